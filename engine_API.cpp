@@ -5,19 +5,53 @@
 namespace Engine
 {
 
-EngineAPI::EngineAPI()
+static uint64_t automatic_transposition_table_size(uint64_t table_bytes)
+/* Return the number of entries of a transposition table that uses at most half of the
+available memory, but not more than the default size. table_bytes is the memory of the
+current table, which is available to a new table.*/
+{
+    const uint64_t available_memory = TranspositionTable::get_available_memory();
+    if (available_memory > UINT64_MAX - table_bytes)
+    {
+        return TranspositionTable::default_size;
+    }
+    return std::min(TranspositionTable::default_size,
+                    (available_memory + table_bytes) / 2 / sizeof(uint64_t));
+}
+
+EngineAPI::EngineAPI() : EngineAPI(std::random_device()()) {}
+
+EngineAPI::EngineAPI(unsigned int seed) :
+    EngineAPI(seed, automatic_transposition_table_size(0)) {}
+
+EngineAPI::EngineAPI(unsigned int seed, uint64_t transposition_table_size,
+                     bool compact_transposition_table) :
+    EngineAPI(seed,
+              std::make_shared<TranspositionTable>(transposition_table_size,
+                                                   compact_transposition_table),
+              std::make_shared<OpeningBook>()) {}
+
+EngineAPI::EngineAPI(unsigned int seed, const std::string& transposition_table_file_name,
+                     TranspositionTable::Storage storage) :
+    EngineAPI(seed,
+              std::make_shared<TranspositionTable>(transposition_table_file_name,
+                                                   automatic_transposition_table_size(0),
+                                                   false, storage),
+              std::make_shared<OpeningBook>()) {}
+
+EngineAPI::EngineAPI(unsigned int seed,
+                     std::shared_ptr<TranspositionTable> transposition_table,
+                     std::shared_ptr<const OpeningBook> opening_book) :
+    opening_book(opening_book),
+    transposition_table(transposition_table),
+    search(*transposition_table),
+    random_generator(seed)
 {
-    // Initialize the random number generator.
-    std::random_device rd;
-    random_generator.seed(rd());
-    difficulty_level_ = 2;
 }
 
-EngineAPI::EngineAPI(unsigned int seed)
+EngineAPI::~EngineAPI()
 {
-    // Initialize the random number generator.
-    random_generator.seed(seed);
-    difficulty_level_ = 2;
+    stop_pondering();
 }
 
 void EngineAPI::set_difficulty_level(int difficulty_level)
@@ -25,14 +59,63 @@ void EngineAPI::set_difficulty_level(int difficulty_level)
     difficulty_level_ = difficulty_level;
 }
 
+void EngineAPI::set_number_of_threads(int number_of_threads)
+{
+    if (number_of_threads < 1) {number_of_threads = 1;}
+    number_of_threads_ = number_of_threads;
+}
+
+void EngineAPI::set_numa_aware(bool numa_aware)
+{
+    if (not numa_aware)
+    {
+        numa_topology = nullptr;
+        return;
+    }
+    if (not numa_topology)
+    {
+        numa_topology = std::make_shared<NumaTopology>();
+        transposition_table->interleave(*numa_topology);
+    }
+}
+
 void EngineAPI::new_game()
 {
+    stop_pondering();
     game_state.reset();
 }
 
+void EngineAPI::set_transposition_table_memory(uint64_t bytes)
+{
+    stop_pondering();
+    if (transposition_table.use_count() > 1)
+    {
+        // Other engines might be searching the table.
+        return;
+    }
+    uint64_t size = bytes / sizeof(uint64_t);
+    if (bytes == 0)
+    {
+        size = automatic_transposition_table_size(
+            transposition_table->get_size() * sizeof(uint64_t));
+    }
+    transposition_table->resize(size, transposition_table->has_compact_entries());
+    if (numa_topology)
+    {
+        // The memory of a resized table is allocated again.
+        transposition_table->interleave(*numa_topology);
+    }
+}
+
 void EngineAPI::clear_transposition_table()
 {
-    transposition_table.clear();
+    stop_pondering();
+    transposition_table->clear();
+}
+
+void EngineAPI::sync_transposition_table()
+{
+    transposition_table->sync();
 }
 
 bool EngineAPI::legal_move(int column)
@@ -42,6 +125,7 @@ bool EngineAPI::legal_move(int column)
 
 int EngineAPI::engine_move()
 {
+    stop_pondering();
     if (difficulty_level_ == 1)
         return engine_move_easy();
     if (difficulty_level_ == 2)
@@ -53,11 +137,46 @@ int EngineAPI::engine_move()
     return 0;
 }
 
+int EngineAPI::engine_move(const SearchLimits& limits)
+{
+    search.set_limits(limits);
+    limited_search = true;
+    const int move = engine_move();
+    limited_search = false;
+    search.set_limits(SearchLimits());
+    return move;
+}
+
 void EngineAPI::make_move(int position)
 {
+    stop_pondering();
     game_state.make_move(position);
 }
 
+void EngineAPI::start_pondering()
+{
+    stop_pondering();
+    if (difficulty_level_ != 3 or game_state.four_in_a_row() or game_state.board_full())
+    {
+        return;
+    }
+    if (not pondering_search)
+    {
+        pondering_search = std::make_unique<Search>(*transposition_table);
+    }
+    pondering_search->reset_stop();
+    pondering_thread = std::thread(&EngineAPI::ponder, this, game_state);
+}
+
+void EngineAPI::stop_pondering()
+{
+    if (pondering_thread.joinable())
+    {
+        pondering_search->stop();
+        pondering_thread.join();
+    }
+}
+
 bool EngineAPI::board_full()
 {
     return game_state.board_full();
@@ -73,6 +192,19 @@ bool EngineAPI::four_in_a_row()
     return game_state.four_in_a_row();
 }
 
+uint64_t EngineAPI::get_number_of_nodes()
+{
+    return search.get_number_of_nodes();
+}
+
+TranspositionTableStatistics EngineAPI::get_transposition_table_statistics()
+{
+    TranspositionTableStatistics statistics = search.get_statistics();
+    transposition_table->count_entries(statistics.entries);
+    statistics.capacity = transposition_table->get_capacity();
+    return statistics;
+}
+
 int EngineAPI::position_heuristic(int move) const
 /* Give a heuristic evaluation in form of a number of how good it would be to make
 the given move to the current game state. The value is higher the better the move.
@@ -147,46 +279,18 @@ random games and count how many is won by the player in turn.*/
 
 std::array<int,7> EngineAPI::move_order()
 {
-    std::array<int,7> moves = {3, 2, 4, 1, 5, 0, 6};
-    int values[7] = {1, 3, 5, 6, 4, 2, 0};
-    const int player = game_state.get_player_in_turn();
-
-    for (int move=0; move<=6; move++)
-    {
-        if(game_state.column_not_full(move))
-        {
-            game_state.make_move(move);
-            values[move] += 100 * game_state.open_four_in_a_row_count(player);
-            game_state.undo_move(move);
-            if(game_state.own_threat_above(move))
-            {
-                values[move] = -100;
-            }
-        }
-    }
-
-    std::sort(moves.begin(), moves.end(),
-                     [&values](int i, int j){return values[i] > values[j];});
-    return moves;
+    return move_order(game_state);
 }
 
-std::array<int,7> EngineAPI::move_order(uint64_t moves_bitboard)
+std::array<int,7> EngineAPI::move_order(GameState& game_state)
 {
     std::array<int,7> moves = {3, 2, 4, 1, 5, 0, 6};
     int values[7] = {1, 3, 5, 6, 4, 2, 0};
     const int player = game_state.get_player_in_turn();
-    const std::array<uint64_t,7> column = {
-        0b0000000000000000000000000000000000000000000111111,
-        0b0000000000000000000000000000000000001111110000000,
-        0b0000000000000000000000000000011111100000000000000,
-        0b0000000000000000000000111111000000000000000000000,
-        0b0000000000000001111110000000000000000000000000000,
-        0b0000000011111100000000000000000000000000000000000,
-        0b0111111000000000000000000000000000000000000000000};
 
     for (int move=0; move<=6; move++)
     {
-        if(moves_bitboard & column[move])
+        if(game_state.column_not_full(move))
         {
             game_state.make_move(move);
             values[move] += 100 * game_state.open_four_in_a_row_count(player);
@@ -218,372 +322,93 @@ std::array<int,7> EngineAPI::move_order(int first_move)
     return {3, 2, 4, 1, 5, 0, 6};
 }
 
-int EngineAPI::negamax(const int depth, int alpha, int beta)
-/* Compute a value of game_state. Return a positive integer for a winning
-game_state for the player in turn, 0 for a draw or unknown outcome and a
-negative integer for a loss. A win at move 42 give the value 100, a win at move 41
-give a the value 200 etc, and vice versa for losses. Heuristic values can be given
-in the range from -99 to 99.
-Depth is counted as the move number at which the search is stopped. For example,
-depth=42 give a maximum depth search. This function can only be used if the
-game state has no four in a row and the player in turn can't make a four
-in a row.*/
+void EngineAPI::start_helper_threads(std::array<int,7> move_order_)
+/* Start number_of_threads_ - 1 helper threads that search the current game state
+together with the main search (Lazy SMP). The helpers share the transposition table
+with the main search and their own results are not used. To make the threads search
+different parts of the tree, each helper starts with a different root move. If the
+engine is NUMA aware, the main thread and the helpers are placed on the NUMA nodes
+in turn until the helpers are stopped.*/
 {
-    uint64_t unique_key;
-    uint64_t key;
-    const int original_alpha = alpha;
-
-    bool use_transposition_table = game_state.get_number_of_moves() < depth - 4;
-    if(beta < 1)
-    {
-        use_transposition_table = false;
-    }
-
-    if (use_transposition_table)
-    {
-        unique_key = game_state.get_unique_key();
-        key = unique_key % transposition_table.size;
-        const uint64_t tt_entry = transposition_table.values[key];
-        const uint64_t tt_key = tt_entry  >> 15;
-        if(tt_key == unique_key)
-        {
-            /* Transposition table data are stored in an unsigned integer.
-            The first 7 bits store value + 50. 50 is added to guarantee that a
-            positive integer is stored. The next 6 bits store depth.
-            Bit 14 is one for lower bounds. Bit 15 is one for upper bounds.
-            The next 49 bits is used for storing a unique key for the transposition.*/
-
-            const int tt_value = (tt_entry & 0b1111111) - 50;
-            const int tt_depth = (tt_entry & 0b1111110000000) >> 7;
-            const bool lower_bound = tt_entry & 0b10000000000000;
-            const bool upper_bound = tt_entry & 0b100000000000000;
-
-            if(tt_depth <= depth and (tt_value != 0 or tt_depth == depth))
-            {
-                if(lower_bound)
-                {
-                    if (tt_value > alpha)
-                    {
-                        alpha = tt_value;
-                    }
-                    if(alpha >= beta)
-                    {
-                        return beta;
-                    }
-                }
-                else if(upper_bound)
-                {
-                    if (tt_value < beta)
-                    {
-                        beta = tt_value;
-                    }
-                    if(alpha >= beta)
-                    {
-                        return alpha;
-                    }
-                }
-            }
-        }
-    }
-
-    const uint64_t non_losing_moves_bitboard = game_state.get_non_losing_moves();
-
-    if (non_losing_moves_bitboard == 0) {return game_state.get_number_of_moves() - 41;}
-
-    if (game_state.get_number_of_moves() >= depth - 2)
-    {
-        return 0;
-    }
-
-    const std::array<uint64_t,7> non_losing_moves = {
-        non_losing_moves_bitboard & 0b0000000000000000000000000000000000000000000111111,
-        non_losing_moves_bitboard & 0b0000000000000000000000000000000000001111110000000,
-        non_losing_moves_bitboard & 0b0000000000000000000000000000011111100000000000000,
-        non_losing_moves_bitboard & 0b0000000000000000000000111111000000000000000000000,
-        non_losing_moves_bitboard & 0b0000000000000001111110000000000000000000000000000,
-        non_losing_moves_bitboard & 0b0000000011111100000000000000000000000000000000000,
-        non_losing_moves_bitboard & 0b0111111000000000000000000000000000000000000000000};
-
-    // Move order.
-    std::array<int,7> moves = {3, 2, 4, 1, 5, 0, 6};
-    if (game_state.get_number_of_moves() < depth - 12)
+    const std::shared_ptr<const NumaTopology> topology =
+        number_of_threads_ > 1 ? numa_topology : nullptr;
+    if (topology)
     {
-        moves = move_order(non_losing_moves_bitboard);
+        topology->pin_current_thread(topology->get_node(0));
     }
-
-    int value;
-    for(int move : moves)
+    for (int i=1; i<number_of_threads_; i++)
     {
-        if (non_losing_moves[move])
-        {
-            game_state.make_move_fast(non_losing_moves[move]);
-            value = -negamax(depth, -beta, -alpha);
-            game_state.undo_move_fast(non_losing_moves[move]);
-            if (value >= beta)
-            {
-                if (use_transposition_table) // Lower bounds
-                {
-                    transposition_table.values[key] = (unique_key << 15)
-                                    | 0b10000000000000 | (depth << 7) | (beta + 50);
-                }
-                return beta;
-            }
-            if (value > alpha)
+        helper_searches.push_back(std::make_unique<Search>(*transposition_table));
+        Search* helper = helper_searches.back().get();
+        helper->set_game_state(game_state);
+        std::array<int,7> helper_move_order = move_order_;
+        std::rotate(helper_move_order.begin(), helper_move_order.begin() + i % 7,
+                    helper_move_order.end());
+        helper_threads.emplace_back([helper, helper_move_order, topology, i]()
             {
-                alpha = value;
-            }
-        }
-    }
-
-    if (use_transposition_table) // Upper bounds
-    {
-        transposition_table.values[key] = (unique_key << 15) | 0b100000000000000 |
-                         (depth << 7) | (alpha + 50);
+                if (topology) {topology->pin_current_thread(topology->get_node(i));}
+                helper->iterative_deepening_full_depth_move(helper_move_order);
+            });
     }
-
-    return alpha;
 }
 
-std::array<int,2> EngineAPI::root_negamax(const int depth,
-                  std::array<int,7> move_order, int alpha, int beta)
-/* Return a move (0 to 6) and a value for the current game state computed
-with the negamax algorithm. Depth is counted as the move number at which
-the search is stopped. This function can only be used if the
-game state has no four in a row and the player in turn can't make a four
-in a row.*/
+void EngineAPI::ponder(GameState game_state)
+/* Search the positions after each move of the player in turn of the given game state,
+in the order of move_order(), until pondering is stopped. Positions where engine_move()
+doesn't search at full depth are skipped.*/
 {
-    int new_value, move, best_move;
-    bool flag = true;
-
-    for (int n=0; n<=6; n++)
+    for (int move : move_order(game_state))
     {
-        move = move_order[n];
-        if (game_state.column_not_full(move))
+        if (pondering_search->stopped())
         {
-            if (flag)
-            {
-                best_move = move;
-                flag = false;
-            }
-            game_state.make_move(move);
-            if(game_state.can_win_this_move())
-            {
-                new_value = game_state.get_number_of_moves() - 42;
-            }
-            else
-            {
-                new_value = -negamax(depth, -beta, -alpha);
-            }
-            game_state.undo_move(move);
-            if (new_value >= beta) // Fail hard beta-cutoff.
-            {
-                return {move, beta};
-            }
-            if (new_value > alpha)
-            {
-                alpha = new_value;
-                best_move = move;
-            }
+            return;
         }
-    }
-    return {best_move, alpha};
-}
-
-int EngineAPI::iterative_deepening_full_depth_value()
-/* Return a value for the current game state. It's best to not use for boards that are
-almost full, to avoid problematic edge cases. This function can only be used if the
-game state has no four in a row and the player in turn can't make a four
-in a row.*/
-{
-    int best_move;
-    const int alpha = -1;
-    const int beta = 1;
-    bool beginning_player_in_turn = game_state.get_number_of_moves() % 2 == 0;
-    int d = game_state.get_number_of_moves() + 2;
-    int value = negamax(d, alpha, beta);
-    if(value < 0)
-    {
-        return d - 43;
-    }
-
-    // Increase d to it's closest larger even number.
-    d += 2 - d % 2;
-
-    while (d <= 42)
-    {
-        value = negamax(d, alpha, beta);
-
-        // If win.
-        if(value > 0)
+        if (not game_state.column_not_full(move))
         {
-            if(beginning_player_in_turn)
-            {
-                return 44 - d;
-            }
-            else
-            {
-                return 43 - d;
-            }
+            continue;
         }
-
-        // If loss.
-        if(value < 0)
+        game_state.make_move(move);
+        bool search_needed = not game_state.four_in_a_row() and
+            game_state.get_number_of_moves() < 37 and not game_state.can_win_this_move() and
+            opening_book->get_best_moves(game_state).empty();
+        for (int column=0; column<=6; column++)
         {
-            if(beginning_player_in_turn)
+            if (game_state.column_not_full(column) and game_state.is_blocking_move(column))
             {
-                return d - 43;
-            }
-            else
-            {
-                return d - 44;
+                search_needed = false;
             }
         }
-
-        // Only every second ply level can be a win and every second a loss.
-        d += 2;
-    }
-    // If draw.
-    return 0;
-}
-
-int EngineAPI::iterative_deepening_full_depth_move(std::array<int,7> move_order_)
-/* Return a move (0 to 6). It's best to not use for boards that are
-almost full, to avoid problematic edge cases. This function can only be used if the
-game state has no four in a row and the player in turn can't make a four
-in a row.*/
-{
-    int value, best_move;
-    int alpha = -1;
-    int beta = 1;
-    int d = game_state.get_number_of_moves() + 2;
-    std::array<int,2> values = root_negamax(d, move_order_, alpha, beta);
-    best_move = values[0];
-    value = values[1];
-
-    // If win or loss
-    if(value != 0)
-    {
-        return {best_move};
-    }
-
-    d += 1;
-
-    while (d <= 42)
-    {
-        // In every other ply level it's not possible to win and in every other
-        // it's not possible to lose.
-        if((game_state.get_number_of_moves() + d) % 2)
-        {
-            // Look for a win
-            alpha = 0;
-            beta = 1;
-
-            values = root_negamax(d, move_order_, alpha, beta);
-            value = values[1];
-
-            if(value > 0)
-            {
-                return {values[0]};
-            }
-        }
-        else
+        if (search_needed)
         {
-            // Look to avoid a loss
-            alpha = -1;
-            beta = 0;
-
-            values = root_negamax(d, move_order_, alpha, beta);
-            value = values[1];
-
-            if(value < 0)
-            {
-                return {best_move};
-            }
-
-            best_move = values[0];
+            pondering_search->set_game_state(game_state);
+            pondering_search->iterative_deepening_full_depth_move_likely_win(
+                move_order(game_state));
         }
-        d += 1;
+        game_state.undo_move(move);
     }
-
-    // If draw.
-    return best_move;
 }
 
-int EngineAPI::iterative_deepening_full_depth_move_likely_win(std::array<int,7> move_order_)
-/* Return a move (0 to 6). It's best to not use for boards that are
-almost full, to avoid problematic edge cases. This function can only be used if the
-game state has no four in a row and the player in turn can't make a four
-in a row. This function is optimized to find a win fast. If there is no win, it might
-be slower than other algorithms.*/
+void EngineAPI::stop_helper_threads()
 {
-    int value, best_move;
-    int alpha = -1;
-    int beta = 1;
-    int d = game_state.get_number_of_moves() + 2;
-    std::array<int,2> values = root_negamax(d, move_order_, alpha, beta);
-    best_move = values[0];
-    value = values[1];
-
-    // If win or loss
-    if(value != 0)
+    for (std::unique_ptr<Search>& helper : helper_searches)
     {
-        return {best_move};
+        helper->stop();
     }
-
-    d += 1;
-
-    while (d <= 42)
+    for (std::thread& thread : helper_threads)
     {
-        // In every other ply level it's not possible to win and in every other
-        // it's not possible to lose.
-        if((game_state.get_number_of_moves() + d) % 2)
-        {
-            // Look for a win
-            alpha = 0;
-            beta = 1;
-
-            values = root_negamax(d, move_order_, alpha, beta);
-            value = values[1];
-
-            if(value > 0)
-            {
-                return {values[0]};
-            }
-        }
-        d += 1;
+        thread.join();
     }
-
-    d = game_state.get_number_of_moves() + 3;
-
-    while (d <= 42)
+    helper_threads.clear();
+    helper_searches.clear();
+    if (numa_topology and number_of_threads_ > 1)
     {
-        // In every other ply level it's not possible to win and in every other
-        // it's not possible to lose.
-        if((game_state.get_number_of_moves() + d) % 2 == 0)
-        {
-            // Look to avoid a loss
-            alpha = -1;
-            beta = 0;
-
-            values = root_negamax(d, move_order_, alpha, beta);
-            value = values[1];
-
-            if(value < 0)
-            {
-                return {best_move};
-            }
-
-            best_move = values[0];
-        }
-        d += 1;
+        numa_topology->unpin_current_thread();
     }
-
-    // If draw.
-    return best_move;
 }
 
 int EngineAPI::position_value_full_depth(const bool use_opening_book)
 {
+    stop_pondering();
     if(game_state.four_in_a_row())
     {
         return game_state.get_number_of_moves() - 43;
@@ -601,22 +426,43 @@ int EngineAPI::position_value_full_depth(const bool use_opening_book)
 
     if(use_opening_book)
     {
-        if(opening_book.can_get_value(game_state))
+        if(opening_book->can_get_value(game_state))
         {
-            return opening_book.get_value(game_state);
+            return opening_book->get_value(game_state);
         }
     }
 
     int alpha = -1000, beta = 1000, depth = 42;
+    search.set_game_state(game_state);
 
     // This is a way of taking care of possible edge case problems with
     // iterative deepening.
     if(game_state.get_number_of_moves() > 36)
     {
-        return negamax(depth, alpha, beta);
+        return search.negamax(depth, alpha, beta);
     }
 
-    return iterative_deepening_full_depth_value();
+    start_helper_threads(move_order());
+    // Compact entries can't store most of the bounds from the null window searches of
+    // bisection, so iterative deepening is used with them.
+    const int value = transposition_table->has_compact_entries() ?
+                      search.iterative_deepening_full_depth_value() :
+                      search.bisection_full_depth_value();
+    stop_helper_threads();
+    return value;
+}
+
+int EngineAPI::position_value_full_depth(const SearchLimits& limits,
+                                         const bool use_opening_book)
+{
+    search.set_limits(limits);
+    int value = position_value_full_depth(use_opening_book);
+    if (search.stopped())
+    {
+        value = unknown_value;
+    }
+    search.set_limits(SearchLimits());
+    return value;
 }
 
 int EngineAPI::engine_move(const int depth)
@@ -653,13 +499,20 @@ is stopped. For example, depth=42 give a maximum depth search.*/
     }
 
     std::array<int,2> values;
+    search.set_game_state(game_state);
     if(depth == 42 and game_state.get_number_of_moves() < 37)
     {
-        return iterative_deepening_full_depth_move_likely_win(moves);
+        start_helper_threads(moves);
+        // If the search can be stopped, every iteration gives a move that can be used.
+        const int move = limited_search ?
+            search.iterative_deepening_full_depth_move(moves) :
+            search.iterative_deepening_full_depth_move_likely_win(moves);
+        stop_helper_threads();
+        return move;
     }
     else
     {
-        values = root_negamax(depth, moves, alpha, beta);
+        values = search.root_negamax(depth, moves, alpha, beta);
     }
 
     return values[0];
@@ -751,7 +604,7 @@ int EngineAPI::engine_move_medium()
         }
     }
 
-    std::vector<int> best_moves = opening_book.get_best_moves(game_state);
+    std::vector<int> best_moves = opening_book->get_best_moves(game_state);
     if(not best_moves.empty())
     {
         return random_move(best_moves);
@@ -789,7 +642,7 @@ int EngineAPI::engine_move_hard()
         }
     }
 
-    std::vector<int> best_moves = opening_book.get_best_moves(game_state);
+    std::vector<int> best_moves = opening_book->get_best_moves(game_state);
     if(not best_moves.empty())
     {
         return(random_move(best_moves));
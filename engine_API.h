@@ -5,9 +5,13 @@
 #include <vector>
 #include <random>
 #include <string>
+#include <memory>
+#include <thread>
 #include "game_state.h"
 #include "opening_book.h"
 #include "transposition_table.h"
+#include "search.h"
+#include "numa_topology.h"
 
 namespace Engine
 {
@@ -18,25 +22,100 @@ public:
     EngineAPI();
 
     EngineAPI(unsigned int seed);
-    // This constructor take a random number generator seed as an argument.
+    /* This constructor take a random number generator seed as an argument. The
+    transposition table of this and the constructor above is sized from the available
+    memory, see set_transposition_table_memory().*/
+
+    EngineAPI(unsigned int seed, uint64_t transposition_table_size,
+              bool compact_transposition_table=false);
+    /* This constructor also take the number of entries in the transposition table.
+    It's rounded down to a power of two. If compact_transposition_table is true, the
+    same memory is used for twice as many compact entries. See transposition_table.h.*/
+
+    EngineAPI(unsigned int seed, const std::string& transposition_table_file_name,
+              TranspositionTable::Storage storage=TranspositionTable::Storage::file);
+    /* This constructor keeps the transposition table in the given file, so that it can
+    be used again by a later process, or in shared memory that is used by all
+    engine processes at the same time. A new table is sized from the available memory
+    as for the constructors above, while an existing table keeps its size. Throws
+    std::runtime_error if the table can't be made. See transposition_table.h.*/
+
+    EngineAPI(unsigned int seed, std::shared_ptr<TranspositionTable> transposition_table,
+              std::shared_ptr<const OpeningBook> opening_book);
+    /* This constructor uses the given transposition table and opening book, which can be
+    shared with other engines in the same process, also engines that are used in
+    other threads. The engines then use each other's search results and only need a
+    few kilobytes of memory each. The table is kept as long as an engine uses it.
+    clear_transposition_table() clears the table for all the engines and must not be
+    called while another engine is searching.*/
+
+    EngineAPI(const EngineAPI&) = delete;
+
+    EngineAPI& operator=(const EngineAPI&) = delete;
+
+    ~EngineAPI();
 
     void set_difficulty_level(int difficulty_level);
     // difficulty_level intended for game play are 1, 2 or 3.
     // Some other levels can be made as well. See the code.
 
+    void set_number_of_threads(int number_of_threads);
+    /* Set the number of threads used for full depth searches. With more than one thread,
+    the threads search the same position and share the transposition table. The results
+    are the same as with one thread. The default is one thread.*/
+
+    void set_numa_aware(bool numa_aware);
+    /* If numa_aware is true, the transposition table is spread evenly over the NUMA
+    nodes of the computer and the threads of full depth searches are placed on the
+    nodes in turn, so that all threads get the same mix of local and remote memory
+    and the memory bandwidth of all nodes is used. This is only useful with several
+    threads on computers with more than one NUMA node. The default is false.*/
+
     void new_game();
 
+    void set_transposition_table_memory(uint64_t bytes=0);
+    /* Resize the transposition table to use at most the given number of bytes. If bytes
+    is 0, the table uses at most half of the memory that is available to the process,
+    including the memory of the current table, but not more than the default size. The
+    available memory is limited by the memory limits of the cgroups of the process.
+    The table is never smaller than 8 MB. This can be done between games. The entries
+    are removed if the size is changed. Tables kept in a file or in shared memory are
+    not resized, and neither is a table that is shared with other EngineAPI objects,
+    since they might be searching it at the same time.*/
+
     void clear_transposition_table();
     /* Normally the transposition table does not need to be cleared. But for some testing it
     can be useful.*/
 
+    void sync_transposition_table();
+    // If the transposition table is kept in a file, wait until it's written to the disk.
+
     bool legal_move(int column);
 
     int engine_move();
     // Return an integer från 0 to 6 that represents a move computed by the engine.
 
+    int engine_move(const SearchLimits& limits);
+    /* Like engine_move(), but the search is stopped when a limit of limits is reached,
+    see search.h. The full depth search of difficulty level 3 is then done with
+    iterative deepening, and the best move of the completed iterations is returned.
+    The move is always legal, but it's not always the best move if the search was
+    stopped. The node budget is for the main search thread.*/
+
     void make_move(int position);
 
+    void start_pondering();
+    /* Search the positions after the moves of the player in turn in a background thread
+    (pondering), with the same searches as engine_move() would do after them. The most
+    likely moves are searched first. The results are kept in the transposition table, so
+    that engine_move() answers almost instantly after a move that was searched. This is
+    only done at difficulty level 3, since the other levels don't search at full depth.
+    Pondering is stopped by stop_pondering() and by the other functions of the engine
+    that change the game state or use the transposition table, for example make_move().*/
+
+    void stop_pondering();
+    // Stop pondering and wait until the background thread has stopped.
+
     bool board_full();
 
     char get_value(int column, int row);
@@ -46,6 +125,15 @@ public:
 
     bool four_in_a_row();
 
+    uint64_t get_number_of_nodes();
+    // Return the number of nodes searched by the main search thread so far.
+
+    TranspositionTableStatistics get_transposition_table_statistics();
+    /* Return statistics of how the main search thread has used the transposition table
+    so far, and the current number of entries in the table. The counters are only
+    counted if the program is compiled with -DTRANSPOSITION_TABLE_STATISTICS.
+    See transposition_table.h.*/
+
     int position_value_full_depth(const bool use_opening_book=true);
     /* Compute a value of the current position at full depth. Return a positive
     integer for a winning game_state for the player in turn, 0 for a draw or unknown
@@ -53,13 +141,27 @@ public:
     a win at move 41 give a the value 2 etc, and vice versa for losses.
     This function can only used for positions that has no four in a rows.*/
 
+    int position_value_full_depth(const SearchLimits& limits,
+                                  const bool use_opening_book=true);
+    /* Like position_value_full_depth(), but return unknown_value if a limit of limits is
+    reached before the value is known.*/
+
+    static const int unknown_value = 1000;
+
 private:
     Engine::GameState game_state;
-    Engine::OpeningBook opening_book;
-    Engine::TranspositionTable transposition_table;
-    int difficulty_level_;
+    std::shared_ptr<const Engine::OpeningBook> opening_book;
+    std::shared_ptr<Engine::TranspositionTable> transposition_table;
+    Engine::Search search;
+    int difficulty_level_ = 2;
+    int number_of_threads_ = 1;
+    bool limited_search = false; // True while a search with limits is done.
     std::mt19937 random_generator;
-    uint64_t transposition_table_2[100000] = {0};
+    std::shared_ptr<const Engine::NumaTopology> numa_topology; // nullptr if not NUMA aware.
+    std::vector<std::unique_ptr<Engine::Search>> helper_searches;
+    std::vector<std::thread> helper_threads;
+    std::unique_ptr<Engine::Search> pondering_search;
+    std::thread pondering_thread;
 
     int position_heuristic(int move) const;
 
@@ -69,22 +171,18 @@ private:
 
     std::array<int,7> move_order();
 
-    std::array<int,7> move_order(uint64_t moves_bitboard);
+    static std::array<int,7> move_order(GameState& game_state);
+    // The move order of move_order() for the given game state.
 
     std::array<int,7> move_order_random_games();
 
     std::array<int,7> move_order(int first_move);
 
-    int negamax(const int depth, int alpha, int beta);
-
-    std::array<int,2> root_negamax(const int depth,
-                  std::array<int,7> move_order, int alpha, int beta);
-
-    int iterative_deepening_full_depth_value();
+    void start_helper_threads(std::array<int,7> move_order_);
 
-    int iterative_deepening_full_depth_move(std::array<int,7> move_order_);
+    void stop_helper_threads();
 
-    int iterative_deepening_full_depth_move_likely_win(std::array<int,7> move_order_);
+    void ponder(GameState game_state);
 
     int engine_move(const int depth);
 
@@ -1,4 +1,8 @@
 #include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include "engine_API.h"
 
 using namespace Engine;
@@ -35,9 +39,36 @@ void print_board(EngineAPI& engine, bool o_make_first_move)
     std::cout << " 0 1 2 3 4 5 6" << std::endl << std::endl;
 }
 
-int main()
+int main(int argc, char* argv[])
+/* With the argument -s, the transposition table is kept in shared memory that is used
+by all engine processes on the computer that are started with -s. The shared memory
+remains after the processes have ended, until the program is run with the argument -r
+or the computer is restarted.*/
 {
-    EngineAPI engine;
+    const std::string shared_memory_name = "/four_in_a_row_transposition_table";
+    if (argc > 1 and std::string(argv[1]) == "-r")
+    {
+        TranspositionTable::remove_shared_memory(shared_memory_name);
+        return 0;
+    }
+
+    std::unique_ptr<EngineAPI> engine_pointer;
+    if (argc > 1 and std::string(argv[1]) == "-s")
+    {
+        try
+        {
+            engine_pointer = std::make_unique<EngineAPI>(std::random_device()(),
+                shared_memory_name, TranspositionTable::Storage::shared_memory);
+        }
+        catch (const std::runtime_error& error)
+        {
+            std::cout << error.what() << ". The transposition table is not shared."
+                      << std::endl << std::endl;
+        }
+    }
+    if (not engine_pointer)
+        engine_pointer = std::make_unique<EngineAPI>();
+    EngineAPI& engine = *engine_pointer;
     char answer[20];
     int move;
     bool player_make_first_move = true;
@@ -80,7 +111,9 @@ int main()
     {
         if (player_in_turn)
         {
-            // Player makes a move.
+            // Player makes a move. The engine searches the likely moves while the
+            // player thinks, until the move is made.
+            engine.start_pondering();
             move = -1;
             while (true)
             {
@@ -161,6 +194,8 @@ int main()
                 {
                     game_over = false;
                     engine.new_game();
+                    // Follow changes of the available memory between games.
+                    engine.set_transposition_table_memory();
                     player_make_first_move = not player_make_first_move;
                     if (player_make_first_move)
                     {
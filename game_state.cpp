@@ -291,6 +291,24 @@ uint64_t GameState::get_non_losing_moves() const
     return next_moves & board_mask & (~(opponent_winning_positions >> 1));
 }
 
+std::array<int,7> GameState::get_threat_counts(uint64_t moves_bitboard) const
+{
+    std::array<int,7> threat_counts;
+    const uint64_t own_bitboard = bitboard[player_in_turn];
+    const uint64_t empty_positions = board_mask & ~(bitboard[0] | bitboard[1]);
+    const uint64_t threats_above =
+        (get_winning_positions_bitboard_non_vertical(own_bitboard) & empty_positions) >> 1;
+    for (int column=0; column<=6; column++)
+    {
+        const uint64_t move = moves_bitboard & (uint64_t(0b111111) << (7 * column));
+        const uint64_t winning_positions = get_winning_positions_bitboard_non_vertical(
+            own_bitboard | move) & empty_positions & ~move;
+        threat_counts[column] = (move & threats_above) ? -1 :
+                                (move ? __builtin_popcountll(winning_positions) : 0);
+    }
+    return threat_counts;
+}
+
 int GameState::open_four_in_a_row_count(int player) const
 {
     std::bitset<64> winning_positions = get_winning_positions_bitboard_non_vertical
@@ -323,23 +341,29 @@ uint64_t GameState::get_unique_key() const
 
 uint64_t GameState::get_unique_mirror_key() const
 {
-    uint64_t key = get_unique_key();
-    uint64_t mirrored_key = 0;
+    // The sum in get_unique_key never carries from one column to the next, so the
+    // mirrored key is the key of the mirrored bitboards.
+    return mirror(get_unique_key());
+}
+
+uint64_t GameState::mirror(uint64_t bitboard)
+{
+    uint64_t mirrored_bitboard = 0;
     const int bitboard_height = 7;
-    mirrored_key |= (key & 0b0000000000000000000000000000000000000000001111111)
+    mirrored_bitboard |= (bitboard & 0b0000000000000000000000000000000000000000001111111)
                     << (bitboard_height * 6);
-    mirrored_key |= (key & 0b0000000000000000000000000000000000011111110000000)
+    mirrored_bitboard |= (bitboard & 0b0000000000000000000000000000000000011111110000000)
                     << (bitboard_height * 4);
-    mirrored_key |= (key & 0b0000000000000000000000000000111111100000000000000)
+    mirrored_bitboard |= (bitboard & 0b0000000000000000000000000000111111100000000000000)
                     << (bitboard_height * 2);
-    mirrored_key |= (key & 0b0000000000000000000001111111000000000000000000000);
-    mirrored_key |= (key & 0b0000000000000011111110000000000000000000000000000)
+    mirrored_bitboard |= (bitboard & 0b0000000000000000000001111111000000000000000000000);
+    mirrored_bitboard |= (bitboard & 0b0000000000000011111110000000000000000000000000000)
                     >> (bitboard_height * 2);
-    mirrored_key |= (key & 0b0000000111111100000000000000000000000000000000000)
+    mirrored_bitboard |= (bitboard & 0b0000000111111100000000000000000000000000000000000)
                     >> (bitboard_height * 4);
-    mirrored_key |= (key & 0b1111111000000000000000000000000000000000000000000)
+    mirrored_bitboard |= (bitboard & 0b1111111000000000000000000000000000000000000000000)
                     >> (bitboard_height * 6);
-    return mirrored_key;
+    return mirrored_bitboard;
 }
 
 int GameState::possible_four_in_a_row_count(bool include_vertical)
@@ -71,6 +71,13 @@ public:
     such that the opponent can't make a four in a row the next move. The bitboard
     have 1:s on the places where the moves are made to and 0:s at all other places*/
 
+    std::array<int,7> get_threat_counts(uint64_t moves_bitboard) const;
+    /* For each column with a move in moves_bitboard, return the number of unoccupied
+    places that give the player in turn a non vertical four in a row after the move,
+    or -1 if the place directly above the move gives the player in turn a non vertical
+    four in a row, so that the opponent can block it directly. Columns without a move
+    get 0. Everything is computed from the bitboards without making the moves.*/
+
     int open_four_in_a_row_count(int player) const;
     /* Return the number of unoccupied places on the board that give player
     a four in a row. player is 0 for the player making the first move and 1
@@ -90,6 +97,10 @@ public:
     /* Return a unique key that corresponds to the mirrored version of the
     current game state.*/
 
+    static uint64_t mirror(uint64_t bitboard);
+    /* Return the bitboard mirrored, so that column 0 becomes column 6 etc. It can also
+    be used on keys and on bitboards of moves.*/
+
     int possible_four_in_a_row_count(bool include_vertical=true);
     /* Return the number of possible four in a rows that can at some stage be made to the
     current game state by the player that made the last move that include at least one
@@ -127,9 +138,9 @@ private:
     int player_in_turn;  // 0 if it's the beginning player in turn and else 1.
     int number_of_moves;
     uint64_t history[42]; // Bitboards from earlier moves.
-    const uint64_t one = 1;
-    const uint64_t board_mask = 0b0111111011111101111110111111011111101111110111111;
-    const uint64_t bottom_row = 0b0000001000000100000010000001000000100000010000001;
+    static constexpr uint64_t one = 1;
+    static constexpr uint64_t board_mask = 0b0111111011111101111110111111011111101111110111111;
+    static constexpr uint64_t bottom_row = 0b0000001000000100000010000001000000100000010000001;
 
     uint64_t next_move(int column) const;
     /* Return a bitboard with a 1 at the position of the next move that can
@@ -148,7 +159,7 @@ private:
     /* Can also include already occupied positions and positions outside the board.*/
 
     // Bitboards for all possible four in a rows.
-    const uint64_t four_in_a_row_bitboards[69] = {
+    static constexpr uint64_t four_in_a_row_bitboards[69] = {
 
     // Vertical:
     0b0000000000000000000000000000000000000000000000000000000000001111,
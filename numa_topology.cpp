@@ -0,0 +1,164 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "numa_topology.h"
+
+namespace Engine
+{
+// From linux/mempolicy.h.
+static const int mpol_interleave = 3;
+static const unsigned int mpol_mf_move = 1 << 1;
+
+static std::vector<int> read_list(const std::string& file_name)
+/* Read a list of numbers in the format used in /sys, for example "0-3,8,10-11".
+Return an empty vector if the file can't be read.*/
+{
+    std::ifstream file_to_read(file_name);
+    std::string line, range;
+    std::vector<int> numbers;
+    std::getline(file_to_read, line);
+    std::stringstream ranges(line);
+    while (std::getline(ranges, range, ','))
+    {
+        const std::string::size_type dash_index = range.find('-');
+        const int first = std::stoi(range.substr(0, dash_index));
+        const int last = dash_index == std::string::npos ? first :
+                         std::stoi(range.substr(dash_index + 1));
+        for (int n=first; n<=last; n++)
+        {
+            numbers.push_back(n);
+        }
+    }
+    return numbers;
+}
+
+NumaTopology::NumaTopology()
+{
+    cpu_set_t allowed_processors;
+    CPU_ZERO(&allowed_processors);
+    sched_getaffinity(0, sizeof(allowed_processors), &allowed_processors);
+
+    for (int node_number : read_list("/sys/devices/system/node/online"))
+    {
+        std::vector<int> node_processors;
+        for (int processor : read_list("/sys/devices/system/node/node" +
+                                       std::to_string(node_number) + "/cpulist"))
+        {
+            if (processor < CPU_SETSIZE and CPU_ISSET(processor, &allowed_processors))
+            {
+                node_processors.push_back(processor);
+            }
+        }
+        // Nodes with only memory are not used, since no thread is local to them.
+        if (not node_processors.empty())
+        {
+            node_numbers.push_back(node_number);
+            processors.push_back(node_processors);
+        }
+    }
+
+    if (node_numbers.empty())
+    {
+        node_numbers.push_back(0);
+        processors.emplace_back();
+        for (int processor=0; processor<CPU_SETSIZE; processor++)
+        {
+            if (CPU_ISSET(processor, &allowed_processors))
+            {
+                processors[0].push_back(processor);
+            }
+        }
+    }
+}
+
+int NumaTopology::get_number_of_nodes() const
+{
+    return node_numbers.size();
+}
+
+int NumaTopology::get_node(int thread_index) const
+{
+    return thread_index % node_numbers.size();
+}
+
+int NumaTopology::get_node_of_processor(int processor) const
+{
+    for (int node=0; node<get_number_of_nodes(); node++)
+    {
+        for (int node_processor : processors[node])
+        {
+            if (node_processor == processor) {return node;}
+        }
+    }
+    return -1;
+}
+
+int NumaTopology::get_node_of_memory(const void* address) const
+{
+    // move_pages without target nodes only reports where the pages are.
+    const void* page = address;
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) != 0 or status < 0)
+    {
+        return -1;
+    }
+    for (int node=0; node<get_number_of_nodes(); node++)
+    {
+        if (node_numbers[node] == status) {return node;}
+    }
+    return -1;
+}
+
+int NumaTopology::current_node() const
+{
+    return get_node_of_processor(sched_getcpu());
+}
+
+bool NumaTopology::pin_current_thread(int node) const
+{
+    cpu_set_t node_processors;
+    CPU_ZERO(&node_processors);
+    for (int processor : processors[node])
+    {
+        CPU_SET(processor, &node_processors);
+    }
+    return sched_setaffinity(0, sizeof(node_processors), &node_processors) == 0;
+}
+
+bool NumaTopology::unpin_current_thread() const
+{
+    cpu_set_t all_processors;
+    CPU_ZERO(&all_processors);
+    for (const std::vector<int>& node_processors : processors)
+    {
+        for (int processor : node_processors)
+        {
+            CPU_SET(processor, &all_processors);
+        }
+    }
+    return sched_setaffinity(0, sizeof(all_processors), &all_processors) == 0;
+}
+
+bool NumaTopology::interleave(void* memory, uint64_t bytes) const
+{
+    if (get_number_of_nodes() == 1) {return true;}
+
+    const int bits_per_word = 8 * sizeof(unsigned long);
+    int max_node_number = 0;
+    for (int node_number : node_numbers)
+    {
+        if (node_number > max_node_number) {max_node_number = node_number;}
+    }
+    std::vector<unsigned long> node_mask(max_node_number / bits_per_word + 1, 0);
+    for (int node_number : node_numbers)
+    {
+        node_mask[node_number / bits_per_word] |= 1UL << (node_number % bits_per_word);
+    }
+    // The kernel reads one bit less than the given number of bits.
+    return syscall(SYS_mbind, memory, bytes, mpol_interleave, node_mask.data(),
+                   node_mask.size() * bits_per_word + 1, mpol_mf_move) == 0;
+}
+}
@@ -0,0 +1,56 @@
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace Engine
+{
+
+class NumaTopology
+/* The NUMA nodes of the computer and the processors of each node. On computers with
+more than one processor socket, each socket has its own memory, and memory of another
+node is slower to use. The topology is read from /sys and the Linux system calls are
+used directly, so no library is needed. Only the processors that the process is
+allowed to use are included. If the topology can't be read, there is one node with
+all allowed processors.*/
+{
+public:
+    NumaTopology();
+
+    int get_number_of_nodes() const;
+
+    int get_node(int thread_index) const;
+    // Return the node index that the thread with the given index is placed on. The
+    // threads are placed on the nodes in turn.
+
+    int get_node_of_processor(int processor) const;
+    // Return the node index of the given processor, or -1 if it's not allowed.
+
+    int get_node_of_memory(const void* address) const;
+    /* Return the node index of the memory at the given address, or -1 if it's not
+    known, for example if the page has not been used yet.*/
+
+    int current_node() const;
+    // Return the node index of the processor that runs the calling thread.
+
+    bool pin_current_thread(int node) const;
+    /* Only let the calling thread run on the processors of the node with the given
+    index. Return false if it fails.*/
+
+    bool unpin_current_thread() const;
+    // Let the calling thread run on all allowed processors again.
+
+    bool interleave(void* memory, uint64_t bytes) const;
+    /* Spread the pages of the given memory evenly over the nodes, page by page, so that
+    threads on all nodes get the same mix of local and remote memory. Pages that are
+    already used are moved. memory must be aligned to a page. Return false if it
+    fails, in which case the memory is where it was.*/
+
+private:
+    std::vector<int> node_numbers; // The node numbers used by the operating system.
+    std::vector<std::vector<int>> processors; // The processors of each node.
+};
+}
+
+#endif
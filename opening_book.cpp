@@ -75,7 +75,7 @@ void OpeningBook::load_opening_book_file(std::string file_name, bool values)
     file_to_read.close();
 }
 
-std::vector<int> OpeningBook::get_best_moves(Engine::GameState& game_state)
+std::vector<int> OpeningBook::get_best_moves(const Engine::GameState& game_state) const
 {
     std::string book_string = "";
     std::vector<int> best_moves;
@@ -83,7 +83,7 @@ std::vector<int> OpeningBook::get_best_moves(Engine::GameState& game_state)
 
     if (opening_book_moves.count(key) == 1)
     {
-        book_string = opening_book_moves[key];
+        book_string = opening_book_moves.at(key);
         for(char move : book_string)
         {
             if (move == '0') best_moves.push_back(0);
@@ -100,7 +100,7 @@ std::vector<int> OpeningBook::get_best_moves(Engine::GameState& game_state)
     key = game_state.get_unique_mirror_key();
     if (opening_book_moves.count(key) == 1)
     {
-        book_string = opening_book_moves[key];
+        book_string = opening_book_moves.at(key);
         for(char move : book_string)
         {
            if (move == '0') best_moves.push_back(6);
@@ -118,14 +118,15 @@ std::vector<int> OpeningBook::get_best_moves(Engine::GameState& game_state)
     {
         std::vector<int> values = {-1000, -1000, -1000, -1000, -1000, -1000, -1000};
         int best_value = -1000;
+        Engine::GameState search_game_state = game_state;
 
         for (int move=0; move<=6; move++)
         {
-            if (game_state.column_not_full(move))
+            if (search_game_state.column_not_full(move))
             {
-                game_state.make_move(move);
-                int value = -negamax(game_state);
-                game_state.undo_move(move);
+                search_game_state.make_move(move);
+                int value = -negamax(search_game_state);
+                search_game_state.undo_move(move);
                 values[move] = value;
                 if(value > best_value)
                 {
@@ -146,17 +147,18 @@ std::vector<int> OpeningBook::get_best_moves(Engine::GameState& game_state)
     return best_moves;
 }
 
-int OpeningBook::can_get_value(Engine::GameState& game_state) const
+int OpeningBook::can_get_value(const Engine::GameState& game_state) const
 {
     return game_state.get_number_of_moves() <= max_ply_for_values_in_opening_book;
 }
 
-int OpeningBook::get_value(Engine::GameState& game_state)
+int OpeningBook::get_value(const Engine::GameState& game_state) const
 {
-    return negamax(game_state);
+    Engine::GameState search_game_state = game_state;
+    return negamax(search_game_state);
 }
 
-int OpeningBook::negamax(Engine::GameState& game_state)
+int OpeningBook::negamax(Engine::GameState& game_state) const
 /* Compute a value of game_state. Return a positive integer for a winning
 game_state for the player in turn, 0 for a draw or unknown outcome and a
 negative integer for a loss. A win at move 42 gives the value 1, a win at move 41
@@ -184,7 +186,7 @@ depth=42 give a maximum depth search.*/
 
     if (opening_book_values.count(key) == 1)
     {
-        book_string = opening_book_values[key];
+        book_string = opening_book_values.at(key);
         return std::stoi(book_string);
     }
     else
@@ -192,7 +194,7 @@ depth=42 give a maximum depth search.*/
        key = game_state.get_unique_mirror_key();
        if (opening_book_values.count(key) == 1)
        {
-          book_string = opening_book_values[key];
+          book_string = opening_book_values.at(key);
           return std::stoi(book_string);
        }
     }
@@ -12,7 +12,7 @@
 
    Compilation and linking:
    g++ -O3 -c make_move_sequence_lists.cpp
-   g++ -o make_move_sequence_lists make_move_sequence_lists.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o
+   g++ -o make_move_sequence_lists make_move_sequence_lists.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o ../search.o ../numa_topology.o
 */
 
 void load_position(Engine::EngineAPI& engine, std::string move_string)
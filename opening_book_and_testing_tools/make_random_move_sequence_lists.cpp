@@ -6,7 +6,7 @@
 
 /* Compilation and linking:
    g++ -O3 -c make_random_move_sequence_lists.cpp
-   g++ -o make_random_move_sequence_lists make_random_move_sequence_lists.o ../engine_API.o ../game_state.o ../opening_book.o
+   g++ -o make_random_move_sequence_lists make_random_move_sequence_lists.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o ../search.o ../numa_topology.o
 */
 
 std::string get_random_move_sequence()
@@ -11,7 +11,7 @@
 
    Compilation and linking:
    g++ -O3 -c make_time_tables.cpp
-   g++ -o make_time_tables make_time_tables.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o
+   g++ -o make_time_tables make_time_tables.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o ../search.o ../numa_topology.o
 */
 
 void load_position(Engine::EngineAPI& engine, std::string move_string)
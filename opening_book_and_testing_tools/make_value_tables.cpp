@@ -1,6 +1,8 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <memory>
+#include <random>
 #include "../engine_API.h"
 
 /* This program takes text files with lists of transpositions as input. Each line should
@@ -14,7 +16,7 @@
 
    Compilation and linking:
    g++ -O3 -c make_value_tables.cpp
-   g++ -o make_value_tables  make_value_tables.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o
+   g++ -o make_value_tables  make_value_tables.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o ../search.o ../numa_topology.o
 */
 
 void load_position(Engine::EngineAPI& engine, std::string move_string)
@@ -44,10 +46,19 @@ void load_position(Engine::EngineAPI& engine, std::string move_string)
     }
 }
 
-int main()
+int main(int argc, char* argv[])
+/* An optional argument gives a file to keep the transposition table in. If the
+   output file already has lines, they are kept and the computation continues after
+   them. Together this makes it possible to stop the program and continue later
+   without losing work. */
 {
     using namespace Engine;
-    EngineAPI engine;
+    std::unique_ptr<EngineAPI> engine_pointer;
+    if (argc > 1)
+        engine_pointer = std::make_unique<EngineAPI>(std::random_device()(), argv[1]);
+    else
+        engine_pointer = std::make_unique<EngineAPI>();
+    EngineAPI& engine = *engine_pointer;
 
     std::string file_with_transpositions;
     std::string file_to_write_to;
@@ -59,10 +70,20 @@ int main()
 
     std::string transposition_move_string;
     std::ifstream file_to_read(file_with_transpositions);
-    std::ofstream file_to_write;
-    file_to_write.open(file_to_write_to);
     int count = 0;
 
+    // Skip the transpositions that are computed already.
+    std::ifstream computed_file(file_to_write_to);
+    std::string line;
+    while (std::getline(computed_file, line))
+        count++;
+    computed_file.close();
+    for (int n=0; n<count; n++)
+        std::getline(file_to_read, transposition_move_string);
+
+    std::ofstream file_to_write;
+    file_to_write.open(file_to_write_to, std::ios::app);
+
     while (std::getline(file_to_read, transposition_move_string))
     {
         load_position(engine, transposition_move_string);
@@ -70,6 +91,8 @@ int main()
         file_to_write << transposition_move_string << " " << std::to_string(value)  << std::endl;
         count++;
         std::cout << count << " transpositions computed" << std::endl;
+        if (count % 100 == 0)
+            engine.sync_transposition_table();
     }
     file_to_read.close();
     file_to_write.close();
@@ -8,7 +8,7 @@
 
    Compilation and linking:
    g++ -O3 -c transposition_list_filter.cpp
-   g++ -o transposition_list_filter transposition_list_filter.o ../engine_API.o ../game_state.o
+   g++ -o transposition_list_filter transposition_list_filter.o ../engine_API.o ../game_state.o ../opening_book.o ../transposition_table.o ../search.o ../numa_topology.o
 */
 
 void load_position(Engine::EngineAPI& engine, std::string move_string)
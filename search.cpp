@@ -0,0 +1,905 @@
+#include <algorithm>
+#include <vector>
+#include "search.h"
+
+// Code in COUNT is only compiled if transposition table statistics are wanted.
+#ifdef TRANSPOSITION_TABLE_STATISTICS
+#define COUNT(statement) statement
+#else
+#define COUNT(statement)
+#endif
+
+namespace Engine
+{
+
+// The positions of the columns on a bitboard.
+static const std::array<uint64_t,7> column_masks = {
+    0b0000000000000000000000000000000000000000000111111,
+    0b0000000000000000000000000000000000001111110000000,
+    0b0000000000000000000000000000011111100000000000000,
+    0b0000000000000000000000111111000000000000000000000,
+    0b0000000000000001111110000000000000000000000000000,
+    0b0000000011111100000000000000000000000000000000000,
+    0b0111111000000000000000000000000000000000000000000};
+
+Search::Search(TranspositionTable& transposition_table) :
+    transposition_table(transposition_table), stop_search(false), number_of_nodes(0),
+    stack_size(0), iterative_depth(0), max_number_of_nodes(UINT64_MAX)
+{
+    killer_moves.fill(0);
+}
+
+void Search::set_game_state(const GameState& game_state)
+{
+    this->game_state = game_state;
+}
+
+void Search::stop()
+{
+    stop_search.store(true, std::memory_order_relaxed);
+}
+
+void Search::reset_stop()
+{
+    stop_search.store(false, std::memory_order_relaxed);
+}
+
+bool Search::stopped() const
+{
+    return stop_search.load(std::memory_order_relaxed);
+}
+
+void Search::set_limits(const SearchLimits& limits)
+{
+    this->limits = limits;
+    max_number_of_nodes = limits.max_nodes > UINT64_MAX - number_of_nodes ?
+                          UINT64_MAX : number_of_nodes + limits.max_nodes;
+    reset_stop();
+}
+
+void Search::check_limits()
+{
+    if (number_of_nodes >= max_number_of_nodes or
+        std::chrono::steady_clock::now() >= limits.deadline or
+        (limits.cancelled and limits.cancelled->load(std::memory_order_relaxed)))
+    {
+        stop();
+    }
+}
+
+uint64_t Search::get_number_of_nodes() const
+{
+    return number_of_nodes;
+}
+
+const TranspositionTableStatistics& Search::get_statistics() const
+{
+    return statistics;
+}
+
+void Search::store(uint64_t key, uint64_t data)
+{
+#ifdef TRANSPOSITION_TABLE_STATISTICS
+    statistics.stores[game_state.get_number_of_moves()]++;
+    statistics.overwrites[game_state.get_number_of_moves()] +=
+        transposition_table.store(key, data);
+#else
+    transposition_table.store(key, data);
+#endif
+}
+
+uint64_t Search::best_move_data(int move, bool mirrored)
+/* Return the bits that store the given best move in transposition table data. If the
+key is the key of the mirrored position, the mirrored move is stored.*/
+{
+    if (mirrored) {move = 6 - move;}
+    return uint64_t(move + 1) << 21;
+}
+
+std::array<int,7> Search::move_order(uint64_t moves_bitboard)
+/* Order the moves in moves_bitboard by the number of threats they make. Moves that let
+the opponent block a threat directly above them are searched last. Central moves are
+searched first among moves with the same number of threats.*/
+{
+    static const int center_values[7] = {1, 3, 5, 6, 4, 2, 0};
+    const std::array<int,7> threat_counts = game_state.get_threat_counts(moves_bitboard);
+
+    // The column is stored in the lowest 3 bits of the sort keys. The center values
+    // make the keys unique.
+    std::array<int,7> keys;
+    for (int column=0; column<=6; column++)
+    {
+        const int value = threat_counts[column] < 0 ? -100 : 100 * threat_counts[column];
+        keys[column] = (value + center_values[column]) * 8 + column;
+    }
+
+    // A sorting network for 7 elements, which sorts the keys in descending order with
+    // a fixed sequence of compare and swaps.
+    static const int network[16][2] = {{0, 6}, {2, 3}, {4, 5}, {0, 2}, {1, 4}, {3, 6},
+        {0, 1}, {2, 5}, {3, 4}, {1, 2}, {4, 6}, {2, 3}, {4, 5}, {1, 2}, {3, 4}, {5, 6}};
+    for (const int* pair : network)
+    {
+        const int larger = std::max(keys[pair[0]], keys[pair[1]]);
+        keys[pair[1]] = std::min(keys[pair[0]], keys[pair[1]]);
+        keys[pair[0]] = larger;
+    }
+
+    std::array<int,7> moves;
+    for (int n=0; n<=6; n++)
+    {
+        moves[n] = keys[n] & 0b111;
+    }
+    return moves;
+}
+
+int Search::negamax(const int depth, int alpha, int beta)
+/* Compute a value of game_state. Return a positive integer for a winning
+game_state for the player in turn, 0 for a draw or unknown outcome and a
+negative integer for a loss. A win at move 42 give the value 100, a win at move 41
+give a the value 200 etc, and vice versa for losses. Heuristic values can be given
+in the range from -99 to 99.
+Depth is counted as the move number at which the search is stopped. For example,
+depth=42 give a maximum depth search. This function can only be used if the
+game state has no four in a row and the player in turn can't make a four
+in a row.*/
+{
+    if (game_state.get_number_of_moves() < depth - 12)
+    {
+        return negamax<Phase::root>(depth, alpha, beta);
+    }
+    if (game_state.get_number_of_moves() < depth - 4)
+    {
+        return negamax<Phase::middle>(depth, alpha, beta);
+    }
+    return negamax<Phase::leaves>(depth, alpha, beta);
+}
+
+template <Search::Phase phase>
+int Search::negamax(const int depth, int alpha, int beta)
+/* negamax for a node in the given phase. The child nodes are in the same phase or in
+the next phase towards the leaves.*/
+{
+    NodeFrame node;
+    node.alpha = alpha;
+    node.beta = beta;
+    int value;
+    if (enter_node<phase>(node, depth, value))
+    {
+        return value;
+    }
+
+    bool first_move = true;
+    for(int move : node.moves)
+    {
+        if (node.non_losing_moves[move])
+        {
+            game_state.make_move_fast(node.non_losing_moves[move]);
+            value = node.children_in_phase ?
+                principal_variation_search<phase>(depth, node.alpha, node.beta,
+                                                  first_move) :
+                principal_variation_search<next_phase(phase)>(depth, node.alpha,
+                                                              node.beta, first_move);
+            first_move = false;
+            game_state.undo_move_fast(node.non_losing_moves[move]);
+            if (stopped()) // The value is not meaningful and must not be stored.
+            {
+                return 0;
+            }
+            if (add_move_value(node, depth, move, value))
+            {
+                return node.beta;
+            }
+        }
+    }
+
+    return leave_node(node, depth);
+}
+
+template <Search::Phase phase>
+bool Search::enter_node(NodeFrame& node, const int depth, int& value)
+/* Do the work of negamax for a node in the given phase before its moves are searched.
+node.alpha and node.beta must be set to the window, and the rest of node is set here.
+Return true if the value of the node is known without searching the moves, and then
+store it in value.*/
+{
+    int& alpha = node.alpha;
+    int& beta = node.beta;
+    uint64_t& unique_key = node.unique_key;
+    bool& mirrored = node.mirrored;
+    mirrored = false; // True if unique_key is the key of the mirrored position.
+    int tt_move = -1;
+    number_of_nodes++;
+    // Reading the clock takes time, so the limits are only checked now and then.
+    if ((number_of_nodes & 0xfff) == 0)
+    {
+        check_limits();
+    }
+
+    // The player in turn can't win this move, so the earliest possible win is at
+    // move number_of_moves + 3. No value can be larger than that win, or than a draw
+    // if the board is full before that move.
+    const int max_value = std::max(40 - game_state.get_number_of_moves(), 0);
+    if (beta > max_value)
+    {
+        beta = max_value;
+        if (alpha >= beta)
+        {
+            value = beta;
+            return true;
+        }
+    }
+
+    node.use_transposition_table = phase != Phase::leaves and beta >= 1;
+
+    if (node.use_transposition_table)
+    {
+        // A position and its mirrored version have the same value and share entry.
+        const uint64_t key = game_state.get_unique_key();
+        const uint64_t mirrored_key = GameState::mirror(key);
+        mirrored = mirrored_key < key;
+        unique_key = mirrored ? mirrored_key : key;
+        const uint64_t tt_entry = transposition_table.probe(unique_key);
+        COUNT(statistics.probes[game_state.get_number_of_moves()]++;)
+        if(tt_entry)
+        {
+            COUNT(statistics.hits[game_state.get_number_of_moves()]++;)
+            // See transposition_table.h for the format of the data.
+            const int tt_value = (tt_entry & 0b1111111) - 50;
+            const int tt_depth = (tt_entry & 0b1111110000000) >> 7;
+            const bool lower_bound = tt_entry & 0b10000000000000;
+            const bool upper_bound = tt_entry & 0b100000000000000;
+            tt_move = ((tt_entry >> 21) & 0b111) - 1;
+            if(mirrored and tt_move >= 0)
+            {
+                tt_move = 6 - tt_move;
+            }
+
+            if(tt_depth <= depth and (tt_value != 0 or tt_depth == depth))
+            {
+                if(lower_bound)
+                {
+                    if (tt_value > alpha)
+                    {
+                        alpha = tt_value;
+                    }
+                    if(alpha >= beta)
+                    {
+                        COUNT(statistics.lower_bound_cutoffs[
+                                  game_state.get_number_of_moves()]++;)
+                        value = beta;
+                        return true;
+                    }
+                }
+                else if(upper_bound)
+                {
+                    if (tt_value < beta)
+                    {
+                        beta = tt_value;
+                    }
+                    if(alpha >= beta)
+                    {
+                        COUNT(statistics.upper_bound_cutoffs[
+                                  game_state.get_number_of_moves()]++;)
+                        value = alpha;
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    const uint64_t non_losing_moves_bitboard = game_state.get_non_losing_moves();
+
+    if (non_losing_moves_bitboard == 0)
+    {
+        value = game_state.get_number_of_moves() - 41;
+        return true;
+    }
+
+    // With a non losing move, the earliest possible loss is at move number_of_moves + 4,
+    // or if the board is full before that, the value is at least a draw.
+    const int min_value = std::min(game_state.get_number_of_moves() - 39, 0);
+    if (alpha < min_value)
+    {
+        alpha = min_value;
+        if (alpha >= beta)
+        {
+            value = alpha;
+            return true;
+        }
+    }
+
+    if (phase == Phase::leaves and game_state.get_number_of_moves() >= depth - 2)
+    {
+        value = 0;
+        return true;
+    }
+
+    std::array<uint64_t,7>& non_losing_moves = node.non_losing_moves;
+    for (int column=0; column<=6; column++)
+    {
+        non_losing_moves[column] = non_losing_moves_bitboard & column_masks[column];
+    }
+
+    // The children are in the same phase unless this node is the last one of its phase.
+    node.children_in_phase = phase == Phase::leaves or
+        (phase == Phase::middle and game_state.get_number_of_moves() + 1 < depth - 4) or
+        (phase == Phase::root and game_state.get_number_of_moves() + 1 < depth - 12);
+    // The transposition table is probed for the child positions if they are searched
+    // with a beta of at least 1, and close to the root also before the moves are searched
+    // (see below). Start to load their entries now, while the move order is computed.
+    std::array<uint64_t,7> child_keys;
+    if (phase == Phase::root or
+        (phase == Phase::middle and node.children_in_phase and alpha <= -1))
+    {
+        // The mirrored version of the move to a column is in the mirrored column.
+        const uint64_t key = game_state.get_unique_key();
+        const uint64_t mirrored_key = GameState::mirror(key);
+        const uint64_t mirrored_moves = GameState::mirror(non_losing_moves_bitboard);
+        const int player = game_state.get_player_in_turn();
+        for (int column=0; column<=6; column++)
+        {
+            if (non_losing_moves[column])
+            {
+                const uint64_t child_key = key + (non_losing_moves[column] << player);
+                const uint64_t mirrored_child_key = mirrored_key +
+                    ((mirrored_moves & column_masks[6 - column]) << player);
+                child_keys[column] = std::min(child_key, mirrored_child_key);
+                transposition_table.prefetch(child_keys[column]);
+            }
+        }
+    }
+
+    // Move order.
+    std::array<int,7>& moves = node.moves;
+    moves = {3, 2, 4, 1, 5, 0, 6};
+    if (phase == Phase::root)
+    {
+        moves = move_order(non_losing_moves_bitboard);
+    }
+    // A move to the same cell as a move that caused a cutoff in another position with
+    // the same number of moves (killer move) often causes a cutoff here too. Moves to
+    // the same column but another cell are not, since they make other threats. The
+    // killer move is searched second, since the first move of the move order is
+    // usually better.
+    const uint64_t killer_move =
+        killer_moves[game_state.get_number_of_moves()] & non_losing_moves_bitboard;
+    if (killer_move)
+    {
+        const int killer_column = __builtin_ctzll(killer_move) / 7;
+        if (moves[0] != killer_column)
+        {
+            std::array<int,7>::iterator killer_position =
+                std::find(moves.begin(), moves.end(), killer_column);
+            std::rotate(moves.begin() + 1, killer_position, killer_position + 1);
+        }
+    }
+    if (tt_move >= 0 and non_losing_moves[tt_move])
+    {
+        // Search the best move from an earlier search first.
+        std::array<int,7>::iterator tt_move_position = std::find(moves.begin(), moves.end(),
+                                                                 tt_move);
+        std::rotate(moves.begin(), tt_move_position, tt_move_position + 1);
+    }
+
+    // Enhanced transposition cutoff. If a child position has an upper bound that is low
+    // enough, the move to it gives a beta cutoff without a search. Close to the root, where
+    // the subtrees are large, that is worth probing all child positions first.
+    if (phase == Phase::root)
+    {
+        for (int column=0; column<=6; column++)
+        {
+            if (non_losing_moves[column])
+            {
+                const uint64_t tt_entry = transposition_table.probe(child_keys[column]);
+                const int tt_value = (tt_entry & 0b1111111) - 50;
+                const int tt_depth = (tt_entry & 0b1111110000000) >> 7;
+                const bool upper_bound = tt_entry & 0b100000000000000;
+                // The child is worth at most tt_value for the opponent, so the move is
+                // worth at least -tt_value.
+                if (upper_bound and -tt_value >= beta and tt_depth <= depth and
+                    (tt_value != 0 or tt_depth == depth))
+                {
+                    if (node.use_transposition_table) // Lower bounds
+                    {
+                        store(unique_key, best_move_data(column, mirrored)
+                              | (game_state.get_number_of_moves() << 15)
+                              | 0b10000000000000 | (depth << 7) | (beta + 50));
+                    }
+                    value = beta;
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+bool Search::add_move_value(NodeFrame& node, const int depth, int move, int value)
+/* Update node with the value of one of its moves, after the move is undone. Return true
+if the value gives a beta cutoff, and then the value of the node is node.beta.*/
+{
+    if (value >= node.beta)
+    {
+        killer_moves[game_state.get_number_of_moves()] = node.non_losing_moves[move];
+        if (node.use_transposition_table) // Lower bounds
+        {
+            store(node.unique_key, best_move_data(move, node.mirrored)
+                  | (game_state.get_number_of_moves() << 15)
+                  | 0b10000000000000 | (depth << 7) | (node.beta + 50));
+        }
+        return true;
+    }
+    if (value > node.alpha)
+    {
+        node.alpha = value;
+    }
+    return false;
+}
+
+int Search::leave_node(NodeFrame& node, const int depth)
+// Return the value of node when all its moves are searched without a beta cutoff.
+{
+    // For upper bounds, no move is better than the others. The best move of an earlier
+    // search of the position is kept.
+    if (node.use_transposition_table) // Upper bounds
+    {
+        store(node.unique_key, (game_state.get_number_of_moves() << 15)
+              | 0b100000000000000 | (depth << 7) | (node.alpha + 50));
+    }
+    return node.alpha;
+}
+
+template <Search::Phase phase>
+int Search::principal_variation_search(const int depth, int alpha, int beta,
+                                       bool first_move)
+/* Return the value of the game state after a move, for the player that made the move,
+as in the loop over the moves in negamax. The first move is searched with the full
+window. Since it's likely the best move, the later moves are first only searched with
+a null window, which is enough to show that they are not better than alpha. Only a
+move that turns out to be better is searched again, with the remaining window. phase is
+the phase of the game state after the move.*/
+{
+    if (first_move or beta - alpha <= 1)
+    {
+        return -negamax<phase>(depth, -beta, -alpha);
+    }
+    const int value = -negamax<phase>(depth, -alpha - 1, -alpha);
+    if (value <= alpha or value >= beta or stopped())
+    {
+        return value;
+    }
+    return -negamax<phase>(depth, -beta, -value);
+}
+
+int Search::principal_variation_search(const int depth, int alpha, int beta,
+                                       bool first_move)
+// principal_variation_search for a game state in any phase.
+{
+    if (game_state.get_number_of_moves() < depth - 12)
+    {
+        return principal_variation_search<Phase::root>(depth, alpha, beta, first_move);
+    }
+    if (game_state.get_number_of_moves() < depth - 4)
+    {
+        return principal_variation_search<Phase::middle>(depth, alpha, beta, first_move);
+    }
+    return principal_variation_search<Phase::leaves>(depth, alpha, beta, first_move);
+}
+
+bool Search::enter_node(NodeFrame& node, const int depth, int& value)
+// enter_node for a node in any phase.
+{
+    if (game_state.get_number_of_moves() < depth - 12)
+    {
+        return enter_node<Phase::root>(node, depth, value);
+    }
+    if (game_state.get_number_of_moves() < depth - 4)
+    {
+        return enter_node<Phase::middle>(node, depth, value);
+    }
+    return enter_node<Phase::leaves>(node, depth, value);
+}
+
+int Search::iterative_negamax(const int depth, int alpha, int beta)
+{
+    iterative_depth = depth;
+    node_stack[0].alpha = alpha;
+    node_stack[0].beta = beta;
+    stack_size = 1;
+    return resume_iterative_negamax();
+}
+
+int Search::resume_iterative_negamax()
+/* Each turn of the outer loop enters the node on top of the stack. The inner loop then
+goes up the stack as long as nodes are finished, and down again to the next move to
+search. The moves are made and undone on game_state as in negamax, and every move is
+searched as in principal_variation_search.*/
+{
+    const int depth = iterative_depth;
+    while (true)
+    {
+        if (stopped())
+        {
+            return 0;
+        }
+
+        NodeFrame* node = &node_stack[stack_size - 1];
+        int value; // The value of the latest finished node.
+        bool finished = enter_node(*node, depth, value);
+        node->move_index = -1;
+        node->first_move = true;
+
+        while (true)
+        {
+            if (finished)
+            {
+                stack_size--;
+                if (stack_size == 0)
+                {
+                    return value;
+                }
+                node = &node_stack[stack_size - 1];
+                const int move = node->moves[node->move_index];
+                value = -value;
+                if (node->move_search == MoveSearch::null_window and
+                    value > node->alpha and value < node->beta)
+                {
+                    // The move is better than alpha and is searched again.
+                    node->move_search = MoveSearch::re_search;
+                    node_stack[stack_size].alpha = -node->beta;
+                    node_stack[stack_size].beta = -value;
+                    stack_size++;
+                    break;
+                }
+                game_state.undo_move_fast(node->non_losing_moves[move]);
+                node->first_move = false;
+                if (add_move_value(*node, depth, move, value))
+                {
+                    value = node->beta;
+                    continue;
+                }
+            }
+
+            // Search the next move of the node, or finish the node if there are no more
+            // moves.
+            do
+            {
+                node->move_index++;
+            }
+            while (node->move_index <= 6 and
+                   not node->non_losing_moves[node->moves[node->move_index]]);
+            if (node->move_index > 6)
+            {
+                value = leave_node(*node, depth);
+                finished = true;
+                continue;
+            }
+            game_state.make_move_fast(node->non_losing_moves[node->moves[node->move_index]]);
+            if (node->first_move or node->beta - node->alpha <= 1)
+            {
+                node->move_search = MoveSearch::full_window;
+                node_stack[stack_size].alpha = -node->beta;
+            }
+            else
+            {
+                node->move_search = MoveSearch::null_window;
+                node_stack[stack_size].alpha = -node->alpha - 1;
+            }
+            node_stack[stack_size].beta = -node->alpha;
+            stack_size++;
+            break;
+        }
+    }
+}
+
+bool Search::iterative_negamax_suspended() const
+{
+    return stack_size > 0;
+}
+
+std::array<int,2> Search::root_negamax(const int depth,
+                  std::array<int,7> move_order, int alpha, int beta)
+/* Return a move (0 to 6) and a value for the current game state computed
+with the negamax algorithm. Depth is counted as the move number at which
+the search is stopped. This function can only be used if the
+game state has no four in a row and the player in turn can't make a four
+in a row.*/
+{
+    int new_value, move, best_move;
+    bool flag = true;
+    bool first_search = true;
+
+    for (int n=0; n<=6; n++)
+    {
+        move = move_order[n];
+        if (game_state.column_not_full(move))
+        {
+            if (flag)
+            {
+                best_move = move;
+                flag = false;
+            }
+            game_state.make_move(move);
+            if(game_state.can_win_this_move())
+            {
+                new_value = game_state.get_number_of_moves() - 42;
+            }
+            else
+            {
+                new_value = principal_variation_search(depth, alpha, beta, first_search);
+                first_search = false;
+            }
+            game_state.undo_move(move);
+            if (stopped())
+            {
+                return {best_move, alpha};
+            }
+            if (new_value >= beta) // Fail hard beta-cutoff.
+            {
+                return {move, beta};
+            }
+            if (new_value > alpha)
+            {
+                alpha = new_value;
+                best_move = move;
+            }
+        }
+    }
+    return {best_move, alpha};
+}
+
+int Search::iterative_deepening_full_depth_value()
+/* Return a value for the current game state. It's best to not use for boards that are
+almost full, to avoid problematic edge cases. This function can only be used if the
+game state has no four in a row and the player in turn can't make a four
+in a row.*/
+{
+    int best_move;
+    const int alpha = -1;
+    const int beta = 1;
+    bool beginning_player_in_turn = game_state.get_number_of_moves() % 2 == 0;
+    int d = game_state.get_number_of_moves() + 2;
+    int value = negamax(d, alpha, beta);
+    if(value < 0)
+    {
+        return d - 43;
+    }
+
+    // Increase d to it's closest larger even number.
+    d += 2 - d % 2;
+
+    while (d <= 42)
+    {
+        value = negamax(d, alpha, beta);
+
+        // If win.
+        if(value > 0)
+        {
+            if(beginning_player_in_turn)
+            {
+                return 44 - d;
+            }
+            else
+            {
+                return 43 - d;
+            }
+        }
+
+        // If loss.
+        if(value < 0)
+        {
+            if(beginning_player_in_turn)
+            {
+                return d - 43;
+            }
+            else
+            {
+                return d - 44;
+            }
+        }
+
+        // Only every second ply level can be a win and every second a loss.
+        d += 2;
+    }
+    // If draw.
+    return 0;
+}
+
+int Search::bisection_full_depth_value(bool iterative)
+/* Return the same value as iterative_deepening_full_depth_value(), but computed with
+null window searches. Each search shows if the value is larger than a given value, and
+the values are chosen by bisection of the values that are still possible, so the
+number of searches grows with the logarithm of the number of possible values. The
+searches use each other's results through the transposition table. This function can
+only be used if the game state has no four in a row and the player in turn can't make
+a four in a row.*/
+{
+    // The player in turn can win at the earliest at move number_of_moves + 3 and lose
+    // at move number_of_moves + 2. Wins are only possible at every second move and so
+    // are losses.
+    const int number_of_moves = game_state.get_number_of_moves();
+    std::vector<int> possible_values;
+    for (int value = number_of_moves - 41; value < 0; value += 2)
+    {
+        possible_values.push_back(value);
+    }
+    possible_values.push_back(0);
+    for (int value = (40 - number_of_moves) % 2 ? 1 : 2; value <= 40 - number_of_moves;
+         value += 2)
+    {
+        possible_values.push_back(value);
+    }
+
+    // The value is in possible_values[low] to possible_values[high].
+    int low = 0;
+    int high = possible_values.size() - 1;
+    while (low < high)
+    {
+        const int middle = (low + high) / 2;
+        const int value = possible_values[middle];
+        // A value larger than value >= 0 is a win at move 42 - value or earlier, and a
+        // value not larger than value < 0 is a loss at move 43 + value or earlier. The
+        // search only has to go that deep, since the value at the depth is 0 otherwise.
+        const int depth = value >= 0 ? 42 - value : 43 + value;
+        const int search_value = iterative ? iterative_negamax(depth, value, value + 1) :
+                                            negamax(depth, value, value + 1);
+        if (stopped()) // The value is not meaningful.
+        {
+            return 0;
+        }
+        if (search_value > value)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return possible_values[low];
+}
+
+int Search::iterative_deepening_full_depth_move(std::array<int,7> move_order_)
+/* Return a move (0 to 6). It's best to not use for boards that are
+almost full, to avoid problematic edge cases. This function can only be used if the
+game state has no four in a row and the player in turn can't make a four
+in a row. If the search is stopped, the best move of the completed iterations is
+returned.*/
+{
+    int value, best_move;
+    int alpha = -1;
+    int beta = 1;
+    int d = game_state.get_number_of_moves() + 2;
+    std::array<int,2> values = root_negamax(d, move_order_, alpha, beta);
+    best_move = values[0];
+    value = values[1];
+
+    // If win or loss
+    if(value != 0 or stopped())
+    {
+        return {best_move};
+    }
+
+    d += 1;
+
+    while (d <= 42)
+    {
+        // In every other ply level it's not possible to win and in every other
+        // it's not possible to lose.
+        if((game_state.get_number_of_moves() + d) % 2)
+        {
+            // Look for a win
+            alpha = 0;
+            beta = 1;
+
+            values = root_negamax(d, move_order_, alpha, beta);
+            value = values[1];
+            if (stopped()) {return best_move;}
+
+            if(value > 0)
+            {
+                return {values[0]};
+            }
+        }
+        else
+        {
+            // Look to avoid a loss
+            alpha = -1;
+            beta = 0;
+
+            values = root_negamax(d, move_order_, alpha, beta);
+            value = values[1];
+            if (stopped()) {return best_move;}
+
+            if(value < 0)
+            {
+                return {best_move};
+            }
+
+            best_move = values[0];
+        }
+        d += 1;
+    }
+
+    // If draw.
+    return best_move;
+}
+
+int Search::iterative_deepening_full_depth_move_likely_win(std::array<int,7> move_order_)
+/* Return a move (0 to 6). It's best to not use for boards that are
+almost full, to avoid problematic edge cases. This function can only be used if the
+game state has no four in a row and the player in turn can't make a four
+in a row. This function is optimized to find a win fast. If there is no win, it might
+be slower than other algorithms. If the search is stopped, the best move of the
+completed iterations is returned.*/
+{
+    int value, best_move;
+    int alpha = -1;
+    int beta = 1;
+    int d = game_state.get_number_of_moves() + 2;
+    std::array<int,2> values = root_negamax(d, move_order_, alpha, beta);
+    best_move = values[0];
+    value = values[1];
+
+    // If win or loss
+    if(value != 0 or stopped())
+    {
+        return {best_move};
+    }
+
+    d += 1;
+
+    while (d <= 42)
+    {
+        // In every other ply level it's not possible to win and in every other
+        // it's not possible to lose.
+        if((game_state.get_number_of_moves() + d) % 2)
+        {
+            // Look for a win
+            alpha = 0;
+            beta = 1;
+
+            values = root_negamax(d, move_order_, alpha, beta);
+            value = values[1];
+            if (stopped()) {return best_move;}
+
+            if(value > 0)
+            {
+                return {values[0]};
+            }
+        }
+        d += 1;
+    }
+
+    d = game_state.get_number_of_moves() + 3;
+
+    while (d <= 42)
+    {
+        // In every other ply level it's not possible to win and in every other
+        // it's not possible to lose.
+        if((game_state.get_number_of_moves() + d) % 2 == 0)
+        {
+            // Look to avoid a loss
+            alpha = -1;
+            beta = 0;
+
+            values = root_negamax(d, move_order_, alpha, beta);
+            value = values[1];
+            if (stopped()) {return best_move;}
+
+            if(value < 0)
+            {
+                return {best_move};
+            }
+
+            best_move = values[0];
+        }
+        d += 1;
+    }
+
+    // If draw.
+    return best_move;
+}
+}
@@ -0,0 +1,163 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include "game_state.h"
+#include "transposition_table.h"
+
+namespace Engine
+{
+
+struct SearchLimits
+/* Limits for a search. The search is stopped as if stop() was called when the deadline
+is passed, when it has searched max_nodes nodes, or when *cancelled becomes true. The
+limits are only checked once every 4096 nodes, so a search can go on for a fraction of
+a millisecond after a limit is reached.*/
+{
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();
+    uint64_t max_nodes = UINT64_MAX;
+    const std::atomic<bool>* cancelled = nullptr; // Set by another thread to cancel.
+};
+
+class Search
+/* The tree search of the engine. A Search object have its own game state, but the
+transposition table can be shared between many Search objects. This makes it possible
+to let several threads search the same position at the same time, where each thread
+have its own Search object.*/
+{
+public:
+    Search(TranspositionTable& transposition_table);
+
+    void set_game_state(const GameState& game_state);
+
+    void stop();
+    /* Make an ongoing search return as soon as possible. Values and moves returned
+    from a stopped search are not meaningful.*/
+
+    void reset_stop();
+
+    bool stopped() const;
+
+    void set_limits(const SearchLimits& limits);
+    /* Limit the searches from now on. The node budget counts from now. This also
+    resets a stopped search. Set the default SearchLimits to remove the limits.*/
+
+    uint64_t get_number_of_nodes() const;
+    // Return the number of calls to negamax since the Search object was created.
+
+    const TranspositionTableStatistics& get_statistics() const;
+    /* Return the statistics of the transposition table use since the Search object was
+    created. Only the counters are given. See transposition_table.h.*/
+
+    int negamax(const int depth, int alpha, int beta);
+
+    int iterative_negamax(const int depth, int alpha, int beta);
+    /* The same search as negamax, with the same value and the same number of nodes, but
+    the nodes that are searched are kept on an explicit stack instead of in recursive
+    calls. If stop() is called, the search is suspended before the next node and 0 is
+    returned. After reset_stop(), the search can be continued where it stopped with
+    resume_iterative_negamax(). The game state of the Search object must not be
+    changed while the search is suspended.*/
+
+    int resume_iterative_negamax();
+    // Continue a suspended iterative_negamax search and return its value.
+
+    bool iterative_negamax_suspended() const;
+    // Return true if an iterative_negamax search is suspended and not finished.
+
+    std::array<int,2> root_negamax(const int depth,
+                  std::array<int,7> move_order, int alpha, int beta);
+
+    int iterative_deepening_full_depth_value();
+
+    int bisection_full_depth_value(bool iterative=false);
+    // If iterative is true, iterative_negamax is used instead of negamax.
+
+    int iterative_deepening_full_depth_move(std::array<int,7> move_order_);
+
+    int iterative_deepening_full_depth_move_likely_win(std::array<int,7> move_order_);
+
+private:
+    enum class Phase {leaves, middle, root};
+    /* Nodes are searched differently depending on how far they are from the depth
+    where the search is stopped. Nodes in the root phase, with number_of_moves <
+    depth - 12, use the transposition table, enhanced transposition cutoffs and move
+    ordering. Nodes in the middle phase, with number_of_moves < depth - 4, use the
+    transposition table. Nodes in the leaves phase use none of them. negamax is
+    compiled separately for each phase, so that a node doesn't check at runtime what
+    it should do.*/
+
+    static constexpr Phase next_phase(Phase phase)
+    // Return the phase that the children of a node at the end of the given phase are in.
+    {
+        return phase == Phase::root ? Phase::middle : Phase::leaves;
+    }
+
+    enum class MoveSearch {full_window, null_window, re_search};
+    // The searches of a move in principal_variation_search.
+
+    struct NodeFrame
+    // A node of negamax that has searched some of its moves.
+    {
+        int alpha;
+        int beta;
+        uint64_t unique_key; // Only set if use_transposition_table is true.
+        bool mirrored; // True if unique_key is the key of the mirrored position.
+        bool use_transposition_table;
+        bool children_in_phase;
+        std::array<uint64_t,7> non_losing_moves; // For each column.
+        std::array<int,7> moves; // The columns in the order they are searched.
+        // Only used by iterative_negamax.
+        int move_index; // The index in moves of the move that is searched.
+        MoveSearch move_search;
+        bool first_move;
+    };
+
+    Engine::GameState game_state;
+    Engine::TranspositionTable& transposition_table;
+    std::atomic<bool> stop_search;
+    uint64_t number_of_nodes;
+    TranspositionTableStatistics statistics;
+    // For each number of moves, the move that most recently caused a beta cutoff, as a
+    // bitboard with a one at the cell of the move.
+    std::array<uint64_t,43> killer_moves;
+    // The stack of iterative_negamax, with the root first. The top node has not been
+    // entered when the search is suspended.
+    std::array<NodeFrame,43> node_stack;
+    int stack_size;
+    int iterative_depth; // The depth of the iterative_negamax search.
+    SearchLimits limits;
+    uint64_t max_number_of_nodes; // number_of_nodes where the node budget runs out.
+
+    void store(uint64_t key, uint64_t data);
+
+    void check_limits();
+    // Stop the search if a limit is reached.
+
+    template <Phase phase>
+    int negamax(const int depth, int alpha, int beta);
+
+    template <Phase phase>
+    bool enter_node(NodeFrame& node, const int depth, int& value);
+
+    bool enter_node(NodeFrame& node, const int depth, int& value);
+
+    bool add_move_value(NodeFrame& node, const int depth, int move, int value);
+
+    int leave_node(NodeFrame& node, const int depth);
+
+    int principal_variation_search(const int depth, int alpha, int beta, bool first_move);
+
+    template <Phase phase>
+    int principal_variation_search(const int depth, int alpha, int beta, bool first_move);
+
+    static uint64_t best_move_data(int move, bool mirrored);
+
+    std::array<int,7> move_order(uint64_t moves_bitboard);
+};
+}
+
+#endif
@@ -1,13 +1,20 @@
 #include <stdlib.h>
 #include <time.h>
+#include <cstdio>
 #include <iostream>
 #include <string>
 #include <chrono>
 #include <vector>
+#include <array>
+#include <random>
+#include <thread>
+#include <atomic>
 #include "../game_state.h"
 #include "../engine_API.h"
 #include "test_engine_API.h"
 #include "../transposition_table.h"
+#include "../search.h"
+#include "../numa_topology.h"
 
 void load_position(Engine::GameState& game_state, std::string move_string)
 /* Load a position to the given game_state object. A position is described
@@ -473,6 +480,41 @@ void test_game_state()
     print_board(game_state);
     std::cout << game_state.open_four_in_a_row_count_2_missing(true) << std::endl;
     std::cout << game_state.open_four_in_a_row_count_2_missing(false) << std::endl;
+
+    std::cout << std::endl;
+    std::cout << "Test mirror keys" << std::endl;
+    std::cout << std::endl;
+    load_position(game_state, "3323312465");
+    const uint64_t key = game_state.get_unique_key();
+    const uint64_t mirror_key = game_state.get_unique_mirror_key();
+    load_position(game_state, "3343354201");
+    std::cout << (game_state.get_unique_key() == mirror_key) << " "
+              << (game_state.get_unique_mirror_key() == key) << std::endl;
+    print_bitboard(GameState::mirror(uint64_t(1) << 36));
+
+    std::cout << "Test threat counts" << std::endl;
+    std::cout << std::endl;
+    // Compare with making the moves. 1 is printed for each column if they agree.
+    for (std::string position : {"3344", "33422", "3323312465", "0112234"})
+    {
+        load_position(game_state, position);
+        const std::array<int,7> threat_counts =
+            game_state.get_threat_counts(game_state.get_non_losing_moves());
+        const int player = game_state.get_player_in_turn();
+        for (int column=0; column<=6; column++)
+        {
+            int threat_count = 0;
+            if (game_state.get_non_losing_moves() & (uint64_t(0b111111) << (7 * column)))
+            {
+                game_state.make_move(column);
+                threat_count = game_state.open_four_in_a_row_count(player);
+                game_state.undo_move(column);
+                if (game_state.own_threat_above(column)) {threat_count = -1;}
+            }
+            std::cout << (threat_counts[column] == threat_count) << " ";
+        }
+        std::cout << std::endl;
+    }
 }
 
 void test_engine_API()
@@ -617,13 +659,83 @@ void test_transposition_table()
     using namespace Engine;
     TranspositionTable tt;
 
-    tt.values[1234] = 5;
-    tt.values[223] = 7;
-    std::cout << tt.values[1234] << " " << tt.values[223] << " " <<
-               tt.values[456] << std::endl;
+    tt.store(1234, 5);
+    tt.store(223, 7);
+    std::cout << tt.probe(1234) << " " << tt.probe(223) << " " <<
+               tt.probe(456) << std::endl;
     tt.clear();
-    std::cout << tt.values[1234] << " " << tt.values[223] << " " <<
-               tt.values[456] << std::endl;
+    std::cout << tt.probe(1234) << " " << tt.probe(223) << " " <<
+               tt.probe(456) << std::endl;
+
+    // Clear many times, so that the generations wrap around.
+    bool cleared = true;
+    for(int i=0; i<600; i++)
+    {
+        tt.store(i, 5);
+        tt.clear();
+        for(int j=0; j<=i; j++)
+        {
+            cleared = cleared and tt.probe(j) == 0;
+        }
+    }
+    std::cout << cleared << std::endl;
+
+    // A resize to more memory than can be allocated keeps the table.
+    tt.store(1234, 5);
+    const uint64_t size_before = tt.get_size();
+    const bool kept = not tt.resize(uint64_t(1) << 50) and tt.get_size() == size_before
+                      and tt.probe(1234) == 5;
+    std::cout << kept << std::endl;
+
+    // Save a table and use it again from the file.
+    tt.store(1234, 5);
+    tt.save("/tmp/test_transposition_table");
+    {
+        TranspositionTable file_tt("/tmp/test_transposition_table");
+        std::cout << file_tt.get_size() << " " << file_tt.probe(1234) << std::endl;
+        file_tt.store(223, 7);
+    }
+    TranspositionTable file_tt("/tmp/test_transposition_table");
+    std::cout << file_tt.probe(1234) << " " << file_tt.probe(223) << std::endl;
+    file_tt.clear();
+    std::cout << file_tt.probe(1234) << " " << file_tt.probe(223) << std::endl;
+    std::remove("/tmp/test_transposition_table");
+
+    // Two tables that use the same shared memory.
+    TranspositionTable shared_tt_1("/test_transposition_table", TranspositionTable::min_size,
+                                   false, TranspositionTable::Storage::shared_memory);
+    TranspositionTable shared_tt_2("/test_transposition_table", TranspositionTable::min_size,
+                                   false, TranspositionTable::Storage::shared_memory);
+    shared_tt_1.store(1234, 5);
+    shared_tt_2.store(223, 7);
+    std::cout << shared_tt_2.probe(1234) << " " << shared_tt_1.probe(223) << std::endl;
+    shared_tt_1.clear();
+    shared_tt_2.clear();
+    std::cout << shared_tt_2.probe(1234) << " " << shared_tt_1.probe(223) << std::endl;
+    TranspositionTable::remove_shared_memory("/test_transposition_table");
+
+    // Compact entries. Bounds outside of -1 to 1 are weakened or not stored.
+    TranspositionTable compact_tt(TranspositionTable::default_size, true);
+    const uint64_t key = (uint64_t(1) << 48) + 1234;
+    compact_tt.store(key, 0b10000000000000 | (20 << 7) | (1 + 50));
+    compact_tt.store(223, 0b100000000000000 | (30 << 7) | (-1 + 50));
+    compact_tt.store(456, 0b10000000000000 | (30 << 7) | (-5 + 50));
+    bool compact_entries_correct = compact_tt.has_compact_entries() and
+        compact_tt.probe(key) == (0b10000000000000 | (20 << 7) | (1 + 50)) and
+        compact_tt.probe(223) == (0b100000000000000 | (30 << 7) | (-1 + 50)) and
+        compact_tt.probe(456) == 0 and compact_tt.probe(1234) == 0;
+    compact_tt.store(key, 0b10000000000000 | (20 << 7) | (7 + 50));
+    compact_entries_correct = compact_entries_correct and
+        compact_tt.probe(key) == (0b10000000000000 | (20 << 7) | (1 + 50));
+    std::cout << "Compact entries" << std::endl;
+    if (compact_entries_correct)
+    {
+        std::cout << "Test successful!" << std::endl;
+    }
+    else
+    {
+        std::cout << "Test failed!" << std::endl;
+    }
 }
 
 void test_position(Engine::EngineAPI& engine, std::string move_string, int expected_move)
@@ -914,6 +1026,87 @@ make the first move*/
               << " ms" << std::endl;
 }
 
+void test_search_limits(Engine::EngineAPI& engine, std::string move_string)
+/* Compute moves and values of the given position with a deadline of 100 ms, a node
+budget of 100000 nodes and a cancellation after 100 ms. Print the moves, the values and
+how long time they took. The position should take longer than 100 ms to compute
+without limits.*/
+{
+    std::chrono::steady_clock::time_point t0;
+    std::chrono::steady_clock::time_point t1;
+    engine.set_difficulty_level(3);
+    load_position(engine, move_string);
+    std::cout << "Position: " << move_string << std::endl;
+
+    Engine::SearchLimits deadline_limits;
+    Engine::SearchLimits node_limits;
+    node_limits.max_nodes = 100000;
+    Engine::SearchLimits cancellation_limits;
+    std::atomic<bool> cancelled(false);
+    cancellation_limits.cancelled = &cancelled;
+    const std::array<std::string,3> names = {"Deadline", "Node budget", "Cancellation"};
+    const std::array<Engine::SearchLimits*,3> limits = {&deadline_limits, &node_limits,
+                                                        &cancellation_limits};
+
+    for (int i=0; i<3; i++)
+    {
+        for (bool value : {false, true})
+        {
+            engine.clear_transposition_table();
+            cancelled = false;
+            std::thread canceller([&cancelled]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                cancelled = true;
+            });
+            const uint64_t nodes_before = engine.get_number_of_nodes();
+            t0 = std::chrono::steady_clock::now();
+            deadline_limits.deadline = t0 + std::chrono::milliseconds(100);
+            const int result = value ? engine.position_value_full_depth(*limits[i]) :
+                                       engine.engine_move(*limits[i]);
+            t1 = std::chrono::steady_clock::now();
+            canceller.join();
+            std::cout << names[i] << (value ? ", value: " : ", move: ") << result
+                      << ", nodes: " << engine.get_number_of_nodes() - nodes_before
+                      << ", time: "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count()
+                      << " ms" << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+void test_pondering(Engine::EngineAPI& engine, std::string move_string, int move,
+                    int pondering_time)
+/* Compare the time of an engine move after the given move with and without pondering
+for pondering_time ms before the move is made. The player in turn after move_string
+makes the given move.*/
+{
+    engine.set_difficulty_level(3);
+    std::chrono::steady_clock::time_point t0;
+    std::chrono::steady_clock::time_point t1;
+    std::cout << "Position: " << move_string << ", move: " << move << std::endl;
+    for (bool pondering : {false, true})
+    {
+        engine.clear_transposition_table();
+        load_position(engine, move_string);
+        if (pondering)
+        {
+            engine.start_pondering();
+            std::this_thread::sleep_for(std::chrono::milliseconds(pondering_time));
+        }
+        engine.make_move(move);
+        t0 = std::chrono::steady_clock::now();
+        const int engine_move = engine.engine_move();
+        t1 = std::chrono::steady_clock::now();
+        std::cout << (pondering ? "With" : "Without") << " pondering, engine move: "
+                  << engine_move << ", time: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count()
+                  << " ms" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
 void benchmark(Engine::EngineAPI& engine)
 {
     test_position(engine, "351524", 0);
@@ -970,11 +1163,250 @@ void benchmark_position_values_no_opening_book(Engine::EngineAPI& engine)
 //    test_position_value(engine, "3563", -3, false);
 }
 
+void benchmark_nodes_per_second(Engine::EngineAPI& engine)
+/* Compute the positions in benchmark() and benchmark_position_values() without
+printing anything and print the number of searched nodes per second.*/
+{
+    const std::vector<std::string> move_positions = {"351524", "443555541", "333345550",
+        "333333010", "334233650026", "01234560660", "00000055551", "2222223456",
+        "333333561", "33423365002630", "3000011243563", "166553001163"};
+    const std::vector<std::string> value_positions = {"333033112", "333633554",
+        "155233161", "002230532", "242222334", "33423365002", "05216116610",
+        "166553001163", "333330211113655"};
+
+    engine.set_difficulty_level(3);
+    const uint64_t nodes_before = engine.get_number_of_nodes();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (std::string position : move_positions)
+    {
+        load_position(engine, position);
+        engine.engine_move();
+    }
+    for (std::string position : value_positions)
+    {
+        load_position(engine, position);
+        engine.position_value_full_depth();
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    const uint64_t nodes = engine.get_number_of_nodes() - nodes_before;
+    const int64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    std::cout << "Nodes: " << nodes << ", Time: " << time << " ms, Nodes per second: "
+              << (time > 0 ? nodes * 1000 / time : 0) << std::endl;
+}
+
+void compare_negamax_cores(std::string file_name)
+/* Compute the values of the positions in a file of values, as in test_from_file_values(),
+with both Search::negamax and Search::iterative_negamax. Print if the values or the
+numbers of nodes differ, and the number of nodes per second of both.*/
+{
+    std::ifstream file_to_read(file_name);
+    std::string line;
+    Engine::GameState game_state;
+    Engine::TranspositionTable transposition_table;
+    // Index 0 is for negamax and 1 for iterative_negamax.
+    std::array<Engine::Search,2> searches = {Engine::Search(transposition_table),
+                                             Engine::Search(transposition_table)};
+    std::array<std::chrono::steady_clock::duration,2> times = {
+        std::chrono::steady_clock::duration::zero(),
+        std::chrono::steady_clock::duration::zero()};
+    int line_number = 0;
+    int differences = 0;
+
+    if(not file_to_read.is_open())
+    {
+        std::cerr << "Can't open " << file_name << std::endl;
+        return;
+    }
+
+    while (std::getline(file_to_read, line))
+    {
+        const std::string::size_type space_index = line.find(' ');
+        load_position(game_state, line.substr(0, space_index));
+        const int expected_value = std::stoi(line.substr(space_index + 1));
+        if (game_state.four_in_a_row() or game_state.board_full() or
+            game_state.can_win_this_move())
+        {
+            continue;
+        }
+
+        // Both searches start with an empty transposition table. Which one is first
+        // changes between the positions, so that both get to use memory that is new to
+        // the process equally often.
+        std::array<int,2> values;
+        std::array<uint64_t,2> nodes;
+        for (int n=0; n<2; n++)
+        {
+            const int i = (n + line_number) % 2;
+            transposition_table.clear();
+            searches[i].set_game_state(game_state);
+            const uint64_t nodes_before = searches[i].get_number_of_nodes();
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            values[i] = searches[i].bisection_full_depth_value(i == 1);
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            times[i] += t1 - t0;
+            nodes[i] = searches[i].get_number_of_nodes() - nodes_before;
+        }
+        line_number++;
+
+        if (values[0] != expected_value or values[1] != expected_value or
+            nodes[0] != nodes[1])
+        {
+            std::cout << "Difference: " << line << ", values: " << values[0] << " "
+                      << values[1] << ", nodes: " << nodes[0] << " " << nodes[1]
+                      << std::endl;
+            differences++;
+        }
+    }
+
+    std::cout << file_name << ", differences: " << differences << std::endl;
+    const std::array<std::string,2> names = {"negamax", "iterative_negamax"};
+    for (int i=0; i<2; i++)
+    {
+        const int64_t time =
+            std::chrono::duration_cast<std::chrono::milliseconds>(times[i]).count();
+        std::cout << names[i] << ": " << searches[i].get_number_of_nodes() << " nodes, "
+                  << time << " ms, Nodes per second: "
+                  << (time > 0 ? searches[i].get_number_of_nodes() * 1000 / time : 0)
+                  << std::endl;
+    }
+}
+
+void compare_compact_transposition_table(std::string file_name)
+/* Compute the values of the positions in a file of values, as in test_from_file_values(),
+with a transposition table of ordinary entries and with one of compact entries of the
+same memory. Compact entries can't store all bounds, but the number of nodes should
+not be more than twice the number with ordinary entries.*/
+{
+    std::ifstream file_to_read(file_name);
+    std::string line;
+    // Index 0 is for ordinary entries and 1 for compact entries.
+    Engine::EngineAPI engine(2153, Engine::TranspositionTable::default_size, false);
+    Engine::EngineAPI compact_engine(2153, Engine::TranspositionTable::default_size, true);
+    std::array<Engine::EngineAPI*,2> engines = {&engine, &compact_engine};
+    int differences = 0;
+
+    if(not file_to_read.is_open())
+    {
+        std::cerr << "Can't open " << file_name << std::endl;
+        return;
+    }
+
+    while (std::getline(file_to_read, line))
+    {
+        const std::string::size_type space_index = line.find(' ');
+        const int expected_value = std::stoi(line.substr(space_index + 1));
+        for (int i=0; i<2; i++)
+        {
+            load_position(*engines[i], line.substr(0, space_index));
+            if (engines[i]->position_value_full_depth() != expected_value)
+            {
+                std::cout << "Wrong value: " << line << std::endl;
+                differences++;
+            }
+        }
+    }
+
+    const uint64_t nodes = engine.get_number_of_nodes();
+    const uint64_t compact_nodes = compact_engine.get_number_of_nodes();
+    std::cout << file_name << ", nodes: " << nodes << ", with compact entries: "
+              << compact_nodes << std::endl;
+    if (differences == 0 and compact_nodes <= 2 * nodes)
+    {
+        std::cout << "Test successful!" << std::endl;
+    }
+    else
+    {
+        std::cout << "Test failed!" << std::endl;
+    }
+}
+
+void test_resume_iterative_negamax(std::string move_string)
+/* Search the given position with Search::negamax and with Search::iterative_negamax,
+where the iterative search is stopped every 10 ms by another thread and resumed. Print
+if the values and the numbers of nodes are the same.*/
+{
+    Engine::GameState game_state;
+    load_position(game_state, move_string);
+    Engine::TranspositionTable transposition_table;
+    Engine::Search recursive_search(transposition_table);
+    Engine::Search iterative_search(transposition_table);
+
+    recursive_search.set_game_state(game_state);
+    const int recursive_value = recursive_search.negamax(42, -1, 1);
+
+    transposition_table.clear();
+    iterative_search.set_game_state(game_state);
+    std::atomic<bool> finished(false);
+    std::thread stopper([&iterative_search, &finished]()
+    {
+        while (not finished)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            iterative_search.stop();
+        }
+    });
+    int suspensions = 0;
+    int iterative_value = iterative_search.iterative_negamax(42, -1, 1);
+    while (iterative_search.iterative_negamax_suspended())
+    {
+        suspensions++;
+        iterative_search.reset_stop();
+        iterative_value = iterative_search.resume_iterative_negamax();
+    }
+    finished = true;
+    stopper.join();
+
+    std::cout << "Position: " << move_string << ", suspensions: " << suspensions
+              << std::endl;
+    std::cout << "Values: " << recursive_value << " " << iterative_value << ", nodes: "
+              << recursive_search.get_number_of_nodes() << " "
+              << iterative_search.get_number_of_nodes() << std::endl;
+    if (recursive_value == iterative_value and
+        recursive_search.get_number_of_nodes() == iterative_search.get_number_of_nodes())
+    {
+        std::cout << "Test successful!" << std::endl;
+    }
+    else
+    {
+        std::cout << "Test failed!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void print_transposition_table_statistics(Engine::EngineAPI& engine)
+/* Print how the transposition table has been used for each number of moves. The
+program must be compiled with -DTRANSPOSITION_TABLE_STATISTICS to get all columns.*/
+{
+    Engine::TranspositionTableStatistics statistics =
+        engine.get_transposition_table_statistics();
+    uint64_t number_of_entries = 0;
+    std::cout << "Moves Probes Hits Lower_cutoffs Upper_cutoffs Stores Overwrites Entries"
+              << std::endl;
+    for (int n=0; n<=42; n++)
+    {
+        number_of_entries += statistics.entries[n];
+        std::cout << n << " " << statistics.probes[n] << " " << statistics.hits[n] << " "
+                  << statistics.lower_bound_cutoffs[n] << " "
+                  << statistics.upper_bound_cutoffs[n] << " " << statistics.stores[n]
+                  << " " << statistics.overwrites[n] << " " << statistics.entries[n]
+                  << std::endl;
+    }
+    std::cout << "Entries: " << number_of_entries << " of " << statistics.capacity
+              << " (" << 100.0 * number_of_entries / statistics.capacity << " %)"
+              << std::endl;
+}
+
 void opening_test()
 {
-    Engine::EngineAPI engine_1;
+    // The engines share one transposition table and one opening book.
+    std::shared_ptr<Engine::TranspositionTable> transposition_table =
+        std::make_shared<Engine::TranspositionTable>();
+    std::shared_ptr<const Engine::OpeningBook> opening_book =
+        std::make_shared<Engine::OpeningBook>();
+    std::random_device random_device;
+    Engine::EngineAPI engine_1(random_device(), transposition_table, opening_book);
     engine_1.set_difficulty_level(4);
-    Engine::EngineAPI engine_2;
+    Engine::EngineAPI engine_2(random_device(), transposition_table, opening_book);
     engine_2.set_difficulty_level(3);
 
     for(int k=1; k<=1000; k++)
@@ -1007,15 +1439,17 @@ void opening_test()
     }
 }
 
-void test_from_file_values(std::string file_name, bool detailed_output = false)
+int test_from_file_values(std::string file_name, bool detailed_output = false,
+                          int number_of_threads = 1)
 /* Test the engine by comparing it's output from moves in a text file. The file should have one line
 per transpositon. Each line should first have a transposition described as a move string followed
-by a space and then a value.*/
+by a space and then a value. Return the total time in ms, or -1 if a test fails.*/
 {
     std::ifstream file_to_read(file_name);
     std::string line, move, c;
     uint64_t key;
     Engine::EngineAPI engine;
+    engine.set_number_of_threads(number_of_threads);
     std::chrono::steady_clock::time_point t0;
     std::chrono::steady_clock::time_point t1;
     std::chrono::steady_clock::duration move_time;
@@ -1025,7 +1459,7 @@ by a space and then a value.*/
     if(not file_to_read.is_open())
     {
         std::cerr << "Can't open " << file_name << std::endl;
-        return;
+        return -1;
     }
 
     std::cout << "Testing " << file_name << std::endl;
@@ -1090,7 +1524,7 @@ by a space and then a value.*/
             {
                 std::cout << "Test failed!" << std::endl << std::endl;
                 std::cout << "The testing was interrupted." << std::endl << std::endl;
-                return;
+                return -1;
             }
         }
     }
@@ -1103,6 +1537,7 @@ by a space and then a value.*/
               << std::chrono::duration_cast<std::chrono::milliseconds>(total_time).count()
               << " ms" << std::endl << std::endl;
     file_to_read.close();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(total_time).count();
 }
 
 void test_from_file_best_moves(std::string file_name, bool detailed_output = false)
@@ -1214,6 +1649,116 @@ by a space and then a string with best moves.*/
     file_to_read.close();
 }
 
+void thread_scaling_test(std::string file_name)
+/* Compute the values in the given file with 1, 2, 4, 8 and 16 threads and print
+the total times and the speedups compared to one thread.*/
+{
+    const int thread_counts[5] = {1, 2, 4, 8, 16};
+    int times[5];
+
+    for (int i=0; i<5; i++)
+    {
+        std::cout << "Threads: " << thread_counts[i] << std::endl;
+        times[i] = test_from_file_values(file_name, false, thread_counts[i]);
+        if (times[i] < 0) {return;}
+    }
+
+    std::cout << "Threads   Time (ms)   Speedup" << std::endl;
+    for (int i=0; i<5; i++)
+    {
+        std::cout << thread_counts[i] << "   " << times[i] << "   "
+                  << (double)times[0] / times[i] << std::endl;
+    }
+}
+
+void numa_probe_benchmark(int number_of_threads, uint64_t transposition_table_size)
+/* Probe a transposition table with random keys from the given number of threads, which
+are placed on the NUMA nodes in turn. Print the share of the probes that go to memory
+on the thread's own node (local) and to other nodes (remote), and how many probes per
+second and thread each kind gets. This is done first for a table that one thread has
+filled, so that all of its memory is on the first node, and then for a table that is
+interleaved over the nodes.*/
+{
+    const Engine::NumaTopology numa_topology;
+    const int keys_per_thread = 1 << 18;
+    std::cout << "NUMA nodes: " << numa_topology.get_number_of_nodes() << std::endl;
+
+    for (bool interleaved : {false, true})
+    {
+        Engine::TranspositionTable transposition_table(transposition_table_size);
+        if (interleaved)
+        {
+            transposition_table.interleave(numa_topology);
+        }
+
+        // Write to all pages, since pages that are only read have no node.
+        numa_topology.pin_current_thread(0);
+        std::mt19937_64 random_generator(1);
+        for (uint64_t i=0; i < transposition_table.get_size() / 4; i++)
+        {
+            transposition_table.store(random_generator() >> 15, 0b10000000000000 | 50);
+        }
+        numa_topology.unpin_current_thread();
+
+        std::vector<std::array<int64_t,4>> results(number_of_threads);
+        std::atomic<uint64_t> checksum(0);
+        std::vector<std::thread> threads;
+        for (int i=0; i<number_of_threads; i++)
+        {
+            threads.emplace_back([&, i]()
+            {
+                numa_topology.pin_current_thread(numa_topology.get_node(i));
+                const int node = numa_topology.current_node();
+                std::mt19937_64 thread_random_generator(i + 2);
+                std::vector<uint64_t> local_keys, remote_keys;
+                for (int k=0; k<keys_per_thread; k++)
+                {
+                    const uint64_t key = thread_random_generator() >> 15;
+                    if (numa_topology.get_node_of_memory(
+                        transposition_table.get_address(key)) == node)
+                    {
+                        local_keys.push_back(key);
+                    }
+                    else
+                    {
+                        remote_keys.push_back(key);
+                    }
+                }
+
+                uint64_t sum = 0;
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                for (uint64_t key : local_keys) {sum += transposition_table.probe(key);}
+                std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+                for (uint64_t key : remote_keys) {sum += transposition_table.probe(key);}
+                std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+                results[i] = {int64_t(local_keys.size()),
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count(),
+                    int64_t(remote_keys.size()),
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count()};
+                checksum += sum; // The probes are not optimized away.
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::array<int64_t,4> total = {0, 0, 0, 0};
+        for (std::array<int64_t,4>& result : results)
+        {
+            for (int n=0; n<4; n++) {total[n] += result[n];}
+        }
+        std::cout << (interleaved ? "Interleaved table" : "Table on the first node")
+                  << std::endl;
+        std::cout << "Local probes: " << 100.0 * total[0] / (total[0] + total[2])
+                  << " %, Probes per second and thread: "
+                  << (total[1] > 0 ? total[0] * 1000000000 / total[1] : 0) << std::endl;
+        std::cout << "Remote probes: " << 100.0 * total[2] / (total[0] + total[2])
+                  << " %, Probes per second and thread: "
+                  << (total[3] > 0 ? total[2] * 1000000000 / total[3] : 0) << std::endl;
+    }
+}
+
 int main()
 {
     std::srand(time(NULL)); // Initialize the random number generator.
@@ -1227,6 +1772,8 @@ int main()
 //    test_from_file_values("./testing/test_transpositions/medium.values", true);
 //    test_from_file_values("./testing/test_transpositions/small.values", true);
 //    test_from_file_values("./testing/test_transpositions/speed_test.values", true);
+//    thread_scaling_test("./testing/test_transpositions/large.values");
+//    numa_probe_benchmark(16, 1 << 26);
 
 //    test_from_file_best_moves("./testing/test_transpositions/large.best_moves", true);
 //    test_from_file_best_moves("./testing/test_transpositions/medium.best_moves", true);
@@ -1251,6 +1798,13 @@ int main()
     engine_vs_engine(engine, test_engine, number_of_games, display_move_times, start_position, 0);
 
 //    benchmark_position_values_no_opening_book(engine);
+//    benchmark_nodes_per_second(engine);
+//    compare_negamax_cores("./testing/test_transpositions/large.values");
+//    compare_compact_transposition_table("./testing/test_transpositions/small.values");
+//    test_search_limits(engine, "256555226");
+//    test_pondering(engine, "25655522", 3, 5000);
+//    test_resume_iterative_negamax("3342");
+//    print_transposition_table_statistics(engine);
 
     return 0;
 }
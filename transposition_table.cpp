@@ -1,24 +1,484 @@
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "transposition_table.h"
 
 namespace Engine
 {
-TranspositionTable::TranspositionTable()
+static uint64_t largest_prime(uint64_t n)
+// Return the largest prime number not larger than n.
 {
-    values = new uint64_t[size];
-    clear();
+    for(; n > 2; n--)
+    {
+        bool prime = n % 2 == 1;
+        for(uint64_t d = 3; prime and d * d <= n; d += 2)
+        {
+            prime = n % d != 0;
+        }
+        if(prime)
+        {
+            return n;
+        }
+    }
+    return 2;
+}
+
+TranspositionTable::TranspositionTable(uint64_t size, bool compact_entries)
+{
+    set_size(size, compact_entries);
+    mapped_bytes = this->size * sizeof(std::atomic<uint64_t>);
+    mapped_memory = map_anonymous_memory(mapped_bytes);
+    header = nullptr;
+    set_values(mapped_memory);
+}
+
+void* TranspositionTable::map_anonymous_memory(uint64_t bytes)
+{
+    /* The memory is mapped directly, to be able to use huge pages. Random probes into
+    a large table are otherwise dominated by TLB misses. Explicit huge pages are only
+    available if they have been reserved, so if that fails, ordinary pages are
+    used together with a request for transparent huge pages. Mapped memory is
+    already zero, so the table doesn't need to be cleared here.*/
+    const uint64_t huge_page_size = 1 << 21;
+    void* memory = MAP_FAILED;
+    if(bytes % huge_page_size == 0)
+    {
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if(memory == MAP_FAILED)
+    {
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(memory == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        madvise(memory, bytes, MADV_HUGEPAGE);
+    }
+    return memory;
+}
+
+TranspositionTable::TranspositionTable(const std::string& file_name, uint64_t size,
+                                       bool compact_entries, Storage storage)
+{
+    const int file_descriptor = storage == Storage::shared_memory ?
+        shm_open(file_name.c_str(), O_RDWR | O_CREAT, 0644) :
+        open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+    if(file_descriptor < 0)
+    {
+        throw std::runtime_error("Can't open " + file_name);
+    }
+
+    // Several processes can open the same table at the same time, so only one at
+    // a time is allowed to check and make the table.
+    flock(file_descriptor, LOCK_EX);
+
+    // Use the table in the file if there is one.
+    FileHeader file_header;
+    struct stat file_status;
+    fstat(file_descriptor, &file_status);
+    bool valid_file =
+        pread(file_descriptor, &file_header, sizeof(file_header), 0) == sizeof(file_header)
+        and file_header.magic_number == magic_number
+        and file_status.st_size == header_bytes + file_header.size * sizeof(uint64_t);
+    if(valid_file)
+    {
+        set_size(file_header.size, file_header.compact_entries);
+        valid_file = this->size == file_header.size
+                     and this->compact_entries == bool(file_header.compact_entries);
+    }
+    if(not valid_file)
+    {
+        // Make a new empty table. A truncated file reads as zeros. The memory is
+        // allocated now, since a page that can't be allocated later, for example when a
+        // small /dev/shm is full, gives SIGBUS when it's used.
+        set_size(size, compact_entries);
+        if(ftruncate(file_descriptor, 0) != 0)
+        {
+            close(file_descriptor);
+            throw std::runtime_error("Can't resize " + file_name);
+        }
+        if(posix_fallocate(file_descriptor, 0,
+                           header_bytes + this->size * sizeof(uint64_t)) != 0)
+        {
+            // Give back what was allocated.
+            ftruncate(file_descriptor, 0);
+            close(file_descriptor);
+            throw std::runtime_error("Can't allocate " + file_name);
+        }
+    }
+
+    mapped_bytes = header_bytes + this->size * sizeof(uint64_t);
+    mapped_memory = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         file_descriptor, 0);
+    if(mapped_memory == MAP_FAILED)
+    {
+        close(file_descriptor);
+        throw std::bad_alloc();
+    }
+    header = static_cast<FileHeader*>(mapped_memory);
+    if(valid_file)
+    {
+        generation = header->generation;
+        generation_tag = generation << (56 - data_bits);
+    }
+    else
+    {
+        header->size = this->size;
+        header->compact_entries = this->compact_entries;
+        header->generation = generation;
+        header->magic_number = magic_number;
+    }
+    // The mapping keeps the file open, and also the lock if it's not released.
+    flock(file_descriptor, LOCK_UN);
+    close(file_descriptor);
+    set_values(static_cast<char*>(mapped_memory) + header_bytes);
 }
 
 TranspositionTable::~TranspositionTable()
 {
-    delete[] values;
+    munmap(mapped_memory, mapped_bytes);
+}
+
+void TranspositionTable::set_size(uint64_t size, bool compact_entries)
+{
+    this->size = rounded_size(size);
+    int size_bits = 0;
+    while((uint64_t(1) << size_bits) < this->size)
+    {
+        size_bits++;
+    }
+    tag_bits = 49 - (size_bits - 3);
+    tag_mask = (uint64_t(1) << tag_bits) - 1;
+    generation = 1;
+    generation_tag = generation << (56 - data_bits);
+
+    compact_size = largest_prime(2 * this->size);
+    this->compact_entries = compact_entries and compact_size > (uint64_t(1) << 26);
+}
+
+uint64_t TranspositionTable::rounded_size(uint64_t size)
+// Round down to the closest power of two, but not below min_size.
+{
+    uint64_t power_of_two = min_size;
+    while(power_of_two <= size / 2)
+    {
+        power_of_two *= 2;
+    }
+    return power_of_two;
+}
+
+void TranspositionTable::set_values(void* memory)
+{
+    values = static_cast<std::atomic<uint64_t>*>(memory);
+    compact_values = static_cast<std::atomic<uint32_t>*>(memory);
+}
+
+bool TranspositionTable::store(uint64_t key, uint64_t data)
+{
+    if(compact_entries)
+    {
+        return store_compact(key, data);
+    }
+    const uint64_t hash = scramble(key);
+    std::atomic<uint64_t>* bucket = values + ((hash >> tag_bits) << 3);
+    const uint64_t tag = hash & tag_mask;
+    const uint64_t depth = (data >> 7) & 0b111111;
+    int replace = 0;
+    int min_priority = 64;
+    bool overwrite = true;
+    for(int i=0; i<8; i++)
+    {
+        const uint64_t entry = bucket[i].load(std::memory_order_relaxed);
+        if((entry >> 56) != generation)
+        {
+            // Empty or from an earlier generation.
+            replace = i;
+            overwrite = false;
+            break;
+        }
+        if(((entry >> data_bits) & tag_mask) == tag)
+        {
+            if((data & best_move_mask) == 0)
+            {
+                // Keep the best move from an earlier search of the position.
+                data |= entry & best_move_mask;
+            }
+            replace = i;
+            overwrite = false;
+            break;
+        }
+        const uint64_t entry_depth = (entry >> 7) & 0b111111;
+        int priority = entry_depth - ((entry >> 15) & 0b111111);
+        if(entry_depth != depth)
+        {
+            // The entry is from a search with another depth, for example an earlier
+            // iteration of iterative deepening, and is less likely to be useful.
+            priority -= 64;
+        }
+        if(priority < min_priority)
+        {
+            min_priority = priority;
+            replace = i;
+        }
+    }
+    bucket[replace].store(((generation_tag | tag) << data_bits) | data,
+                          std::memory_order_relaxed);
+    return overwrite;
+}
+
+uint64_t TranspositionTable::probe_compact(uint64_t key) const
+{
+    const uint32_t entry = compact_values[key % compact_size].load(std::memory_order_relaxed);
+    if(entry == 0 or (entry >> 9) != key / compact_size)
+    {
+        return 0;
+    }
+    // Convert to the data format of ordinary entries.
+    const int value = int(entry & 0b11) - 2;
+    const uint64_t depth = (entry >> 3) & 0b111111;
+    const uint64_t bound = (entry & 0b100) ? 0b10000000000000 : 0b100000000000000;
+    return bound | (depth << 7) | uint64_t(value + 50);
+}
+
+bool TranspositionTable::store_compact(uint64_t key, uint64_t data)
+{
+    int value = (data & 0b1111111) - 50;
+    const uint32_t depth = (data >> 7) & 0b111111;
+    const bool lower_bound = data & 0b10000000000000;
+    if(lower_bound)
+    {
+        if(value < -1) {return false;}
+        if(value > 1) {value = 1;}
+    }
+    else
+    {
+        if(value > 1) {return false;}
+        if(value < -1) {value = -1;}
+    }
+    const uint32_t entry = ((key / compact_size) << 9) | (depth << 3) |
+                           (lower_bound << 2) | (value + 2);
+    std::atomic<uint32_t>& compact_value = compact_values[key % compact_size];
+    const uint32_t old_entry = compact_value.load(std::memory_order_relaxed);
+    compact_value.store(entry, std::memory_order_relaxed);
+    return old_entry != 0 and (old_entry >> 9) != (entry >> 9);
 }
 
 void TranspositionTable::clear()
 {
-    for(int i=0; i < size; i++)
+    if(compact_entries)
+    {
+        clear_memory();
+        return;
+    }
+    if(header)
+    {
+        // Other processes that use the same table might have increased it.
+        generation = header->generation;
+    }
+    generation++;
+    if(generation == 256)
+    {
+        // Entries from the generation that is reused must not be found again.
+        clear_memory();
+        generation = 1;
+    }
+    generation_tag = generation << (56 - data_bits);
+    if(header)
+    {
+        header->generation = generation;
+    }
+}
+
+void TranspositionTable::clear_memory()
+// Set every value in the table to zero.
+{
+    // Private anonymous pages that are given back are zero on the next access.
+    // That is not true for pages of a file.
+    if(not header and
+       madvise(values, size * sizeof(std::atomic<uint64_t>), MADV_DONTNEED) == 0)
+    {
+        return;
+    }
+    for(uint64_t i=0; i < size; i++)
+    {
+        values[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void TranspositionTable::save(const std::string& file_name) const
+{
+    std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+    FileHeader file_header;
+    file_header.magic_number = magic_number;
+    file_header.size = size;
+    file_header.compact_entries = compact_entries;
+    file_header.generation = generation;
+    file.write(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
+    file.seekp(header_bytes);
+    file.write(reinterpret_cast<const char*>(values), size * sizeof(uint64_t));
+    if(not file)
+    {
+        throw std::runtime_error("Can't write " + file_name);
+    }
+}
+
+bool TranspositionTable::interleave(const NumaTopology& numa_topology)
+{
+    return numa_topology.interleave(mapped_memory, mapped_bytes);
+}
+
+bool TranspositionTable::resize(uint64_t size, bool compact_entries)
+{
+    if(header)
+    {
+        return false;
+    }
+    if(rounded_size(size) == this->size and
+       (compact_entries and compact_size > (uint64_t(1) << 26)) == this->compact_entries)
+    {
+        return true;
+    }
+    // The old memory is kept until the new memory is mapped, so that the table is
+    // unchanged if there is not enough memory.
+    const uint64_t bytes = rounded_size(size) * sizeof(std::atomic<uint64_t>);
+    void* memory;
+    try
+    {
+        memory = map_anonymous_memory(bytes);
+    }
+    catch(const std::bad_alloc&)
+    {
+        return false;
+    }
+    munmap(mapped_memory, mapped_bytes);
+    mapped_memory = memory;
+    mapped_bytes = bytes;
+    set_size(size, compact_entries);
+    set_values(memory);
+    return true;
+}
+
+uint64_t TranspositionTable::get_available_memory()
+{
+    uint64_t available_memory = UINT64_MAX;
+
+    // MemAvailable is given in kB.
+    std::ifstream meminfo("/proc/meminfo");
+    std::string name;
+    uint64_t kilobytes;
+    while(meminfo >> name >> kilobytes)
+    {
+        if(name == "MemAvailable:")
+        {
+            available_memory = kilobytes * 1024;
+            break;
+        }
+        meminfo.ignore(256, '\n');
+    }
+
+    /* A memory limit can be set on the cgroup of the process or on any cgroup above it.
+    The line of cgroup version 2 in /proc/self/cgroup is "0::path" and a line of
+    version 1 with the memory controller is "number:memory:path". In a container, the
+    path is often not visible, but the limit of the container is then in the root.*/
+    std::ifstream cgroup_file("/proc/self/cgroup");
+    std::string line;
+    while(std::getline(cgroup_file, line))
+    {
+        std::string directory, limit_file, usage_file;
+        if(line.compare(0, 3, "0::") == 0)
+        {
+            directory = std::ifstream("/sys/fs/cgroup/cgroup.controllers") ?
+                        "/sys/fs/cgroup" : "/sys/fs/cgroup/unified";
+            limit_file = "memory.max";
+            usage_file = "memory.current";
+        }
+        else if(line.find(":memory:") != std::string::npos)
+        {
+            directory = "/sys/fs/cgroup/memory";
+            limit_file = "memory.limit_in_bytes";
+            usage_file = "memory.usage_in_bytes";
+        }
+        else
+        {
+            continue;
+        }
+        std::string path = line.substr(line.find(':', line.find(':') + 1) + 1);
+        while(true)
+        {
+            std::ifstream limit_stream(directory + path + "/" + limit_file);
+            std::ifstream usage_stream(directory + path + "/" + usage_file);
+            uint64_t limit, usage;
+            // An unlimited cgroup of version 2 has the limit "max", which is not read.
+            if(limit_stream >> limit and usage_stream >> usage)
+            {
+                available_memory = std::min(available_memory,
+                                            limit > usage ? limit - usage : 0);
+            }
+            if(path.empty() or path == "/")
+            {
+                break;
+            }
+            path = path.substr(0, path.rfind('/'));
+        }
+    }
+    return available_memory;
+}
+
+void TranspositionTable::remove_shared_memory(const std::string& name)
+{
+    shm_unlink(name.c_str());
+}
+
+void TranspositionTable::sync()
+{
+    if(header)
     {
-        values[i] = 0;
+        msync(mapped_memory, mapped_bytes, MS_SYNC);
     }
 }
+
+uint64_t TranspositionTable::get_size() const
+{
+    return size;
+}
+
+uint64_t TranspositionTable::get_capacity() const
+{
+    return compact_entries ? compact_size : size;
+}
+
+void TranspositionTable::count_entries(std::array<uint64_t,43>& entries) const
+{
+    entries.fill(0);
+    if(compact_entries)
+    {
+        for(uint64_t i=0; i < compact_size; i++)
+        {
+            entries[0] += compact_values[i].load(std::memory_order_relaxed) != 0;
+        }
+        return;
+    }
+    for(uint64_t i=0; i < size; i++)
+    {
+        const uint64_t entry = values[i].load(std::memory_order_relaxed);
+        if((entry >> 56) == generation)
+        {
+            entries[(entry >> 15) & 0b111111]++;
+        }
+    }
+}
+
+bool TranspositionTable::has_compact_entries() const
+{
+    return compact_entries;
+}
 }
@@ -1,22 +1,248 @@
 #ifndef TRANSPOSITION_TABLE_H
 #define TRANSPOSITION_TABLE_H
 
+#include <array>
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include "numa_topology.h"
+
 namespace Engine
 {
 
+struct TranspositionTableStatistics
+/* Statistics of how a transposition table is used by a search. The arrays are indexed
+by the number of moves of the positions. The counters are only counted if the
+program is compiled with -DTRANSPOSITION_TABLE_STATISTICS, since counting slows down
+the search. entries and capacity are always given.*/
+{
+    std::array<uint64_t,43> probes{};
+    std::array<uint64_t,43> hits{}; // Probes that found the position.
+    std::array<uint64_t,43> lower_bound_cutoffs{};
+    std::array<uint64_t,43> upper_bound_cutoffs{};
+    std::array<uint64_t,43> stores{};
+    std::array<uint64_t,43> overwrites{}; // Stores that replaced another position.
+    std::array<uint64_t,43> entries{}; // Positions in the table.
+    uint64_t capacity = 0; // The number of positions that fit in the table.
+};
+
 class TranspositionTable
+/* A table that can be shared between many search threads without locks. Every
+entry is a single 64 bit word that holds both the key and the data of a transposition,
+so an entry is always read and written as a whole and a probe can never see a
+mixture of two stores. Relaxed atomic loads and stores compile to ordinary moves,
+so a single thread pays nothing for this.
+
+The entries are grouped in buckets of 8 entries, where each bucket fills one
+64 byte cache line. A key can be stored in any entry of its bucket.
+
+The data of an entry is stored in the lowest 24 bits:
+The first 7 bits store value + 50. 50 is added to guarantee that a positive
+integer is stored. The next 6 bits store depth. Bit 14 is one for lower bounds.
+Bit 15 is one for upper bounds. The next 6 bits store the number of moves
+of the transposition. The next 3 bits store the best move + 1, or 0 if there
+is no best move. The next bits store a tag that together with the
+bucket index identifies the key. The highest 8 bits store the generation of the
+entry. Entries from earlier generations are treated as empty, which makes it possible
+to clear the table by increasing the generation.
+
+With compact entries, the table instead holds twice as many entries of 32 bits.
+The number of entries is then a prime p and a key is stored at index key % p. Only
+key / p needs to be stored to identify the key, which is less than 2^23 if p > 2^26.
+Bit 0-1 store value + 2, bit 2 is one for lower bounds and zero for upper bounds,
+bit 3-8 store depth and bit 9-31 store key / p. To fit the value in two bits,
+lower bounds above 1 are stored as 1 and upper bounds below -1 as -1, which is
+still correct. Other bounds outside of -1 to 1 are not stored. Most bounds from
+iterative deepening are within -1 to 1, but most bounds from the null window searches
+of bisection are not, and a search by bisection with compact entries was measured to
+need 17 times as many nodes as with ordinary entries. Therefore EngineAPI uses
+iterative deepening with compact entries. It needs between a quarter and a half more
+nodes than bisection with ordinary entries of the same memory, so compact entries are
+only useful when the positions don't fit in a table of ordinary entries.
+Compact entries don't store best moves. There is no room for a generation either,
+so clearing a table with compact entries instead gives the memory back to the
+operating system, which gives zeroed pages back on the next access.*/
 {
 public:
-    TranspositionTable();
+    TranspositionTable(uint64_t size=default_size, bool compact_entries=false);
+    /* size is the number of entries. It's rounded down to the closest power of two,
+    but it's never smaller than min_size. If compact_entries is true, the same
+    memory is used for twice as many compact entries, but only if that gives more than
+    2^26 compact entries. Otherwise ordinary entries are used.*/
+
+    enum class Storage {file, shared_memory};
+
+    TranspositionTable(const std::string& file_name, uint64_t size=default_size,
+                       bool compact_entries=false, Storage storage=Storage::file);
+    /* A table that is kept in the given file, so that it survives the process.
+    Everything that is stored is written to the file by the operating system, also if
+    the process crashes, and sync() makes sure that it has reached the disk. If the
+    file has a table made by this constructor or by save(), that table is used as it
+    is, with its own size and entry format. Otherwise a new empty table is made in
+    the file. Since the file is mapped, opening a large table is instant and the
+    pages are read when they are used. Throws std::runtime_error if the file can't
+    be opened.
+
+    With Storage::shared_memory, file_name is instead the name of a POSIX shared
+    memory object, for example "/four_in_a_row". All processes on the computer that
+    open the same name use the same table at the same time, and the memory is only
+    used once. The shared memory object remains until remove_shared_memory() is
+    called or the computer is restarted.*/
+
+    TranspositionTable(const TranspositionTable&) = delete;
+
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
 
     ~TranspositionTable();
 
     void clear();
-    // Set every value in the table to zero.
+    /* Remove all entries. This takes constant time, except for once every 255 calls
+    when the generations wrap around and the table is overwritten with zeros. Other
+    processes that use the same table keep their entries until they call clear().*/
+
+    uint64_t probe(uint64_t key) const
+    /* Return the data stored for the given key, or 0 if the key is not in the table.
+    key must be smaller than 2^49.*/
+    {
+        if(compact_entries)
+        {
+            return probe_compact(key);
+        }
+        const uint64_t hash = scramble(key);
+        const std::atomic<uint64_t>* bucket = values + ((hash >> tag_bits) << 3);
+        const uint64_t tag = hash & tag_mask;
+        // Empty entries and entries from other generations never match since the
+        // generation is never 0.
+        for(int i=0; i<8; i++)
+        {
+            const uint64_t entry = bucket[i].load(std::memory_order_relaxed);
+            if((entry >> data_bits) == (generation_tag | tag))
+            {
+                return entry & data_mask;
+            }
+        }
+        return 0;
+    }
+
+    void prefetch(uint64_t key) const
+    /* Start to load the memory where the given key is stored into the cache, so that a
+    later probe or store of the key doesn't have to wait for it.*/
+    {
+        __builtin_prefetch(get_address(key));
+    }
+
+    const void* get_address(uint64_t key) const
+    // Return the address of the memory where the given key is stored.
+    {
+        if(compact_entries)
+        {
+            return compact_values + key % compact_size;
+        }
+        return values + ((scramble(key) >> tag_bits) << 3);
+    }
+
+    bool store(uint64_t key, uint64_t data);
+    /* Store data for the given key. If the bucket of the key is full, an entry from a
+    search with another depth is replaced first, and otherwise the entry with the
+    least remaining depth (depth - number of moves). That keeps the entries that are
+    expensive to compute, which are the ones close to the root. Return true if an
+    entry of another key in the current generation was replaced.*/
+
+    bool resize(uint64_t size, bool compact_entries=false);
+    /* Change the size of the table and remove all entries, with the same rules for size
+    and compact_entries as in the constructor. If the table already has that size,
+    nothing is changed. Tables that are kept in a file or in shared memory can't be
+    resized, and false is returned for them. false is also returned if the memory of
+    the new size can't be allocated, and the table is then unchanged. The table must
+    not be used by a search at the same time.*/
+
+    static uint64_t get_available_memory();
+    /* Return the number of bytes that the process can allocate before it runs out of
+    memory. That is the smallest of MemAvailable in /proc/meminfo and what remains of
+    the memory limit of the cgroup of the process, and of the cgroups above it, for
+    both cgroup version 1 and 2. Without any limit, UINT64_MAX is returned.*/
+
+    void save(const std::string& file_name) const;
+    /* Write a snapshot of the table to the given file, which can be used by the file
+    constructor later. Throws std::runtime_error if it fails. The table must not be
+    used by a search at the same time.*/
+
+    bool interleave(const NumaTopology& numa_topology);
+    /* Spread the memory of the table evenly over the NUMA nodes, so that search threads
+    on all nodes can use it equally fast. Return false if it fails.*/
+
+    static void remove_shared_memory(const std::string& name);
+
+    void sync();
+    // Wait until a table that is kept in a file is written to the disk.
+
+    uint64_t get_size() const;
+
+    uint64_t get_capacity() const;
+    // Return the number of entries, which is larger than size for compact entries.
+
+    void count_entries(std::array<uint64_t,43>& entries) const;
+    /* Count the entries of the current generation for each number of moves. This goes
+    through the whole table. Compact entries don't store the number of moves, so they
+    are all counted at index 0.*/
+
+    bool has_compact_entries() const;
+
+    static constexpr uint64_t default_size = 1 << 26;
+
+    static constexpr uint64_t min_size = 1 << 20; // 8 MB. Smaller tables leave too few tag bits.
+
+private:
+    struct FileHeader
+    {
+        uint64_t magic_number;
+        uint64_t size;
+        uint64_t compact_entries;
+        uint64_t generation;
+    };
+
+    // Identifies table files. It's changed when the format of the entries is changed.
+    static constexpr uint64_t magic_number = 0x34494e41524f5755;
+    static constexpr uint64_t header_bytes = 4096; // The entries start on a new page.
+
+    void* mapped_memory;
+    uint64_t mapped_bytes;
+    FileHeader* header; // The header of the file, or nullptr if there is no file.
+    std::atomic<uint64_t>* values;
+    std::atomic<uint32_t>* compact_values; // The same memory as values.
+    uint64_t size;
+    int tag_bits;
+    uint64_t tag_mask;
+    uint64_t generation; // From 1 to 255.
+    uint64_t generation_tag; // The generation shifted to be compared with entry >> data_bits.
+    bool compact_entries;
+    uint64_t compact_size;
+    static constexpr int data_bits = 24;
+    static constexpr uint64_t data_mask = (1 << data_bits) - 1;
+    static constexpr uint64_t best_move_mask = 0b111 << 21;
+
+    uint64_t probe_compact(uint64_t key) const;
+
+    bool store_compact(uint64_t key, uint64_t data);
+
+    static uint64_t rounded_size(uint64_t size);
+
+    static void* map_anonymous_memory(uint64_t bytes);
+    // Throws std::bad_alloc if the memory can't be mapped.
+
+    void set_size(uint64_t size, bool compact_entries);
+
+    void set_values(void* memory);
 
-    uint64_t* values;
+    void clear_memory();
 
-    const int size = 50000000;
+    static uint64_t scramble(uint64_t key)
+    /* A bijection on 49 bit integers. The highest bits of the result depend on all bits
+    of the key and are used as bucket index. Since it's a bijection, only the remaining
+    bits need to be stored to identify a key.*/
+    {
+        return (key * 0x9E3779B97F4A7C15) & ((uint64_t(1) << 49) - 1);
+    }
 };
 }
 